@@ -0,0 +1,246 @@
+// Headless benchmark of the ball physics, no window or Vulkan device needed.
+// Build with `make physics_bench`, ./physics_bench --help lists the options.
+
+#include "lve_ball_store.hpp"
+#include "lve_ball_physics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lve;
+
+namespace{
+
+    struct Scene{
+        const char* name;
+        int ballCount;
+        float maxRadius;
+        // smallest radius as a fraction of maxRadius, loadBalls uses 0.3
+        float minRadiusFactor;
+        float maxSpeed;
+        // balls this many times larger than maxRadius, spawned in a band along the top
+        int largeCount;
+        float largeFactor;
+    };
+
+    // balls on a jittered lattice inside [-1, 1] x [bottom, top], so they never overlap and
+    // spawning stays linear
+    void spawnLattice(int count, float minRadius, float maxRadius, float maxSpeed, float bottom, float top,
+            std::mt19937& rng, LveBallStore& balls){
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> unifSpeed(-maxSpeed, maxSpeed);
+
+        const float height = top - bottom;
+        const int perRow = std::min(static_cast<int>(std::ceil(std::sqrt(count * 2.0f / height))),
+            static_cast<int>(1.0f / maxRadius));
+        const float cell = 2.0f / perRow;
+        const int rows = static_cast<int>(height / cell);
+        for(int i = 0; i < count && i < perRow * rows; i++){
+            float radius = minRadius + (maxRadius - minRadius) * unit(rng);
+            float slack = cell * 0.5f - radius;
+            float x = -1.0f + cell * (i % perRow + 0.5f) + slack * (2.0f * unit(rng) - 1.0f);
+            float y = bottom + cell * (i / perRow + 0.5f) + slack * (2.0f * unit(rng) - 1.0f);
+            balls.add(x, y, unifSpeed(rng), unifSpeed(rng), radius, radius);
+        }
+    }
+
+    void spawn(const Scene& scene, LveBallStore& balls){
+        std::mt19937 rng(1234);
+        float top = 1.0f;
+        if(scene.largeCount > 0){
+            float largeRadius = scene.maxRadius * scene.largeFactor;
+            int perRow = static_cast<int>(1.0f / largeRadius);
+            top -= 2.0f * largeRadius * ((scene.largeCount + perRow - 1) / perRow);
+            spawnLattice(scene.largeCount, largeRadius, largeRadius, scene.maxSpeed, top, 1.0f, rng, balls);
+        }
+        spawnLattice(scene.ballCount - scene.largeCount, scene.maxRadius * scene.minRadiusFactor, scene.maxRadius,
+            scene.maxSpeed, -1.0f, top, rng, balls);
+    }
+
+    struct Result{
+        size_t ballCount;
+        // wall clock time of every step in milliseconds
+        std::vector<double> stepMs;
+        size_t candidates;
+    };
+
+    Result measure(const Scene& scene, PhysicsSystem::Broadphase broadphase, int steps, unsigned threads){
+        LveBallStore balls;
+        spawn(scene, balls);
+        PhysicsSystem physics{balls, broadphase};
+        physics.setThreadCount(threads);
+
+        const float dt = 1.0f / 240.0f;
+        Result result{balls.size(), {}, 0};
+        result.stepMs.reserve(steps);
+        for(int i = 0; i < steps; i++){
+            auto start = std::chrono::high_resolution_clock::now();
+            physics.update(dt);
+            auto end = std::chrono::high_resolution_clock::now();
+            result.stepMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            result.candidates += physics.getLastCandidateCount();
+        }
+        return result;
+    }
+
+    double totalMs(const Result& result){
+        double total = 0.0;
+        for(double ms : result.stepMs){
+            total += ms;
+        }
+        return total;
+    }
+
+    // nearest rank percentile of the step times
+    double percentile(std::vector<double> stepMs, double fraction){
+        if(stepMs.empty()){
+            return 0.0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(fraction * stepMs.size()));
+        rank = std::min(std::max(rank, size_t{1}), stepMs.size()) - 1;
+        std::nth_element(stepMs.begin(), stepMs.begin() + rank, stepMs.end());
+        return stepMs[rank];
+    }
+
+    struct BroadphaseName{
+        PhysicsSystem::Broadphase broadphase;
+        const char* name;
+    };
+    const BroadphaseName broadphaseNames[] = {
+        {PhysicsSystem::Broadphase::BruteForce, "brute"},
+        {PhysicsSystem::Broadphase::UniformGrid, "grid"},
+        {PhysicsSystem::Broadphase::SortAndSweep, "sweep"},
+        {PhysicsSystem::Broadphase::AabbTree, "tree"},
+    };
+
+    void printTable(){
+        const Scene scenes[] = {
+            {"equal radii", 10000, 0.006f, 1.0f, 0.5f, 0, 1.0f},
+            {"radii 0.3x-1x", 10000, 0.006f, 0.3f, 0.5f, 0, 1.0f},
+            {"radii 0.05x-1x", 10000, 0.006f, 0.05f, 0.5f, 0, 1.0f},
+            {"few large, radii 0.3x-1x", 2000, 0.02f, 0.3f, 0.5f, 0, 1.0f},
+            {"1% of balls 10x larger", 10000, 0.004f, 0.3f, 0.5f, 100, 10.0f},
+        };
+        const int steps = 100;
+
+        std::printf("%-24s %-10s %8s %12s %14s\n", "scene", "broadphase", "balls", "ms/step", "cand/ball");
+        for(const auto& scene : scenes){
+            for(const auto& broadphase : broadphaseNames){
+                if(broadphase.broadphase == PhysicsSystem::Broadphase::BruteForce){
+                    continue;
+                }
+                Result result = measure(scene, broadphase.broadphase, steps, 0);
+                std::printf("%-24s %-10s %8zu %12.3f %14.1f\n", scene.name, broadphase.name, result.ballCount,
+                    totalMs(result) / steps, static_cast<double>(result.candidates) / steps / result.ballCount);
+            }
+        }
+    }
+
+    const char* usage =
+        "usage: physics_bench [options]\n"
+        "without options prints a table comparing the broadphases on a few scenes,\n"
+        "with any option runs one scene and prints the result as JSON\n"
+        "  --balls N          number of balls (10000)\n"
+        "  --radius R         largest radius in arena units, the arena is 2 wide (0.006)\n"
+        "  --min-radius F     smallest radius as a fraction of --radius (0.3)\n"
+        "  --large N          balls spawned --large-factor times larger than --radius (0)\n"
+        "  --large-factor F   (10)\n"
+        "  --speed S          largest starting speed per axis in units per second (0.5)\n"
+        "  --steps N          steps of 1/240 s to run (100)\n"
+        "  --threads N        0 runs the ordered single threaded step (0)\n"
+        "  --broadphase B     brute, grid, sweep or tree (grid)\n";
+
+    void runFromArguments(int argc, char** argv){
+        Scene scene{"custom", 10000, 0.006f, 0.3f, 0.5f, 0, 10.0f};
+        int steps = 100;
+        unsigned threads = 0;
+        const BroadphaseName* broadphase = &broadphaseNames[1];
+
+        for(int i = 1; i < argc; i++){
+            std::string option = argv[i];
+            if(option == "--help" || option == "-h"){
+                std::fputs(usage, stdout);
+                return;
+            }
+            if(i + 1 >= argc){
+                throw std::runtime_error("missing value for " + option);
+            }
+            std::string value = argv[++i];
+            if(option == "--balls"){
+                scene.ballCount = std::stoi(value);
+            }
+            else if(option == "--radius"){
+                scene.maxRadius = std::stof(value);
+            }
+            else if(option == "--min-radius"){
+                scene.minRadiusFactor = std::stof(value);
+            }
+            else if(option == "--large"){
+                scene.largeCount = std::stoi(value);
+            }
+            else if(option == "--large-factor"){
+                scene.largeFactor = std::stof(value);
+            }
+            else if(option == "--speed"){
+                scene.maxSpeed = std::stof(value);
+            }
+            else if(option == "--steps"){
+                steps = std::stoi(value);
+            }
+            else if(option == "--threads"){
+                threads = static_cast<unsigned>(std::stoul(value));
+            }
+            else if(option == "--broadphase"){
+                auto found = std::find_if(std::begin(broadphaseNames), std::end(broadphaseNames),
+                    [&](const BroadphaseName& name){return value == name.name;});
+                if(found == std::end(broadphaseNames)){
+                    throw std::runtime_error("unknown broadphase " + value);
+                }
+                broadphase = found;
+            }
+            else{
+                throw std::runtime_error("unknown option " + option + "\n" + usage);
+            }
+        }
+        if(scene.ballCount <= 0 || steps <= 0 || scene.maxRadius <= 0.0f || scene.largeCount > scene.ballCount
+                || scene.minRadiusFactor <= 0.0f || scene.minRadiusFactor > 1.0f){
+            throw std::runtime_error("invalid scene");
+        }
+
+        Result result = measure(scene, broadphase->broadphase, steps, threads);
+        double seconds = totalMs(result) / 1000.0;
+        std::printf("{\n");
+        std::printf("  \"broadphase\": \"%s\",\n", broadphase->name);
+        std::printf("  \"balls\": %zu,\n", result.ballCount);
+        std::printf("  \"threads\": %u,\n", threads);
+        std::printf("  \"steps\": %d,\n", steps);
+        std::printf("  \"steps_per_sec\": %.3f,\n", seconds > 0.0 ? steps / seconds : 0.0);
+        std::printf("  \"pair_tests_per_step\": %.1f,\n", static_cast<double>(result.candidates) / steps);
+        std::printf("  \"step_ms_p50\": %.4f,\n", percentile(result.stepMs, 0.5));
+        std::printf("  \"step_ms_p99\": %.4f\n", percentile(result.stepMs, 0.99));
+        std::printf("}\n");
+    }
+}
+
+int main(int argc, char** argv){
+    try{
+        if(argc > 1){
+            runFromArguments(argc, argv);
+        }
+        else{
+            printTable();
+        }
+    }catch (const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
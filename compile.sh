@@ -1,2 +1,4 @@
 /usr/local/bin/glslc shaders/simple_shader.vert -o shaders/simple_shader.vert.spv
 /usr/local/bin/glslc shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
+/usr/local/bin/glslc shaders/instanced_shader.vert -o shaders/instanced_shader.vert.spv
+/usr/local/bin/glslc shaders/cull.comp -o shaders/cull.comp.spv
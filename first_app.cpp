@@ -1,7 +1,12 @@
 #include "first_app.hpp"
 #include "simple_render_system.hpp"
-//#include "lve_ball_physics.hpp"
+#include "lve_ball_physics.hpp"
 #include "lve_camera.hpp"
+#include "lve_gpu_culling.hpp"
+#include "lve_frame_ring.hpp"
+#include "lve_pipeline_compiler.hpp"
+#include "lve_pipeline_variants.hpp"
+#include "lve_poisson_disk.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -11,15 +16,45 @@
 #include <chrono>
 #include <math.h>
 #include <iostream>
+#include <algorithm>
 
 
 
 namespace lve
 {
 
-    FirstApp::FirstApp()
+    static void printFrameStats(FirstApp::RenderPath renderPath, float framesPerSecond, const SimpleRendererSystem &system, const LveGpuCulling *gpuCulling)
+    {
+        static const char *pathNames[] = {"gpu", "instanced", "parallel", "serial"};
+        std::cout << pathNames[static_cast<int>(renderPath)] << ": " << framesPerSecond << " fps";
+        if (renderPath == FirstApp::RenderPath::GpuCulled)
+        {
+            std::cout << ", " << gpuCulling->getVisibleCount() << " visible, " << gpuCulling->getCulledCount() << " culled" << std::endl;
+            return;
+        }
+        const auto &cullCounts = system.getCullCounts();
+        std::cout << ", " << cullCounts.visible << " visible, " << cullCounts.culled << " culled";
+        if (renderPath != FirstApp::RenderPath::Instanced)
+        {
+            const auto &binds = system.getBindCounts();
+            std::cout << ", " << binds.draws << " draws, " << binds.pipelineBinds << " pipeline and " << binds.modelBinds
+                      << " model binds (" << system.getUnsortedModelBinds() << " model binds unsorted), "
+                      << binds.redundantPipelineBinds << " pipeline and " << binds.redundantModelBinds << " model binds skipped";
+        }
+        std::cout << std::endl;
+    }
+
+    FirstApp::FirstApp(const Options &options) : options{options}
     {
         loadGameObjects();
+        if (!options.printStats)
+        {
+            return;
+        }
+        auto memory = lveDevice.getMemoryStats();
+        std::cout << "gpu memory: " << memory.allocationCount << " allocations in " << memory.deviceAllocationCount
+                  << " device allocations, " << memory.usedBytes / 1024 << " of " << memory.reservedBytes / 1024
+                  << " KiB used, fragmentation " << memory.fragmentation() << std::endl;
     }
 
     FirstApp::~FirstApp()
@@ -27,17 +62,49 @@ namespace lve
     }
     void FirstApp::run()
     {
-        SimpleRendererSystem simpleRendererSystem{lveDevice, lveRenderer.getSwapChainRenderPass()};
+        LveFrameRing frameRing{lveDevice};
+        // declared before the systems, they wait for their pipelines when they are destroyed
+        LvePipelineVariants pipelineVariants{lveDevice};
+        LvePipelineCompiler pipelineCompiler{pipelineVariants, 2};
+        SimpleRendererSystem simpleRendererSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), frameRing, pipelineCompiler, OBJECT_COLORS};
+        RenderPath renderPath = options.renderPath;
+        std::unique_ptr<LveGpuCulling> gpuCulling;
+        if (renderPath == RenderPath::GpuCulled)
+        {
+            try
+            {
+                gpuCulling = std::make_unique<LveGpuCulling>(lveDevice);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "gpu culling unavailable, drawing instanced: " << e.what() << std::endl;
+                renderPath = RenderPath::Instanced;
+            }
+        }
+        std::unique_ptr<LveParallelRecorder> recorder;
+        if (renderPath == RenderPath::Parallel)
+        {
+            recorder = std::make_unique<LveParallelRecorder>(lveDevice, options.threads);
+        }
         LveCamera camera{};
         
-       // PhysicsSystem ballPhyisicsSystem(gameObjects);
+        PhysicsSystem ballPhyisicsSystem{balls};
+        ballPhyisicsSystem.setThreadCount(options.threads);
         
-
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        float accumulator = 0.0f;
+        int statsFrames = 0;
+        float statsTime = 0.0f;
        
         while (!lveWindow.shouldClose())
         {
 
             glfwPollEvents(); // gleda sve user evenete
+
+            auto newTime = std::chrono::high_resolution_clock::now();
+            float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+            currentTime = newTime;
+            accumulator = std::min(accumulator + frameTime, MAX_PHYSICS_STEPS_PER_FRAME * PHYSICS_STEP);
             float aspect = lveRenderer.getAspectRatio();
          //  camera.setOrthographicProjection(-aspect,aspect ,-1,1,-1,1);
             camera.setPerspectiveProjection(glm::radians(50.f), aspect, .1f, 10.f);
@@ -50,12 +117,56 @@ namespace lve
                 // your draw function
 
                 // my system update fucntions
-               // ballPhyisicsSystem.update();
-                // render system
-                lveRenderer.beginSwapChainRenderPass(commandBuffer);
-                simpleRendererSystem.renderGameObjects(commandBuffer, gameObjects, camera);
-                lveRenderer.endSwapChainRenderPass(commandBuffer);
+                while (accumulator >= PHYSICS_STEP)
+                {
+                    ballPhyisicsSystem.update(PHYSICS_STEP);
+                    accumulator -= PHYSICS_STEP;
+                }
+                updateBallObjects(ballPhyisicsSystem, accumulator / PHYSICS_STEP);
+                simpleRendererSystem.animateGameObjects(gameObjects);
+                int frameIndex = lveRenderer.getFrameIndex();
+                frameRing.beginFrame(frameIndex);
+                if (renderPath == RenderPath::Parallel)
+                {
+                    LveParallelRecorder::Target target{lveRenderer.getSwapChainRenderPass(), lveRenderer.getCurrentFrameBuffer(), lveRenderer.getSwapChainExtent()};
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    simpleRendererSystem.renderGameObjectsParallel(commandBuffer, frameIndex, *recorder, target, gameObjects, camera);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+                else if (renderPath == RenderPath::Serial)
+                {
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer);
+                    simpleRendererSystem.renderGameObjects(commandBuffer, gameObjects, camera);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+                else if (renderPath == RenderPath::Instanced)
+                {
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer);
+                    simpleRendererSystem.renderGameObjectsInstanced(commandBuffer, gameObjects, camera);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+                else
+                {
+                    // culling runs as a compute pass, so it is recorded before the render pass
+                    gpuCulling->cull(commandBuffer, frameIndex, gameObjects, camera);
+                    // render system
+                    lveRenderer.beginSwapChainRenderPass(commandBuffer);
+                    simpleRendererSystem.renderCulledGameObjects(commandBuffer, frameIndex, *gpuCulling, camera);
+                    lveRenderer.endSwapChainRenderPass(commandBuffer);
+                }
                 lveRenderer.endFrame();
+
+                if (options.printStats)
+                {
+                    statsFrames++;
+                    statsTime += frameTime;
+                    if (statsTime >= 1.0f)
+                    {
+                        printFrameStats(renderPath, statsFrames / statsTime, simpleRendererSystem, gpuCulling.get());
+                        statsFrames = 0;
+                        statsTime = 0.0f;
+                    }
+                }
             }
         }
 
@@ -63,103 +174,58 @@ namespace lve
         vkDeviceWaitIdle(lveDevice.device());
     }
 
-    // bool checkIfOccupided(float xPos, float yPos, std::vector<glm::vec2> &positions, float radius, float delta)
-    // {
-    //     float minDistance = 10.0f;
-    //     glm::vec2 point;
-    //     for (auto p : positions)
-    //     {
-    //         float distance = sqrt(pow(xPos - p.x, 2.0f) + pow(yPos - p.y, 2.0f));
-    //         if (distance < minDistance)
-    //         {
-    //             minDistance = distance;
-    //             point.x = p.x;
-    //             point.y = p.y;
-    //         }
-    //         if (distance < 2 * radius + delta)
-    //         {
-    //             return true;
-    //         }
-    //     }
-    //     // std::cout << "{" <<xPos << ", "<<yPos<<"}, "<<"{"<<point.x <<", "
-    //     //  << point.y << "}, distance :"<<minDistance - 2*radius << ", radius: "<<radius<<  std::endl;
-    //     return false;
-    // }
-
     void FirstApp::loadBalls(int numOfBalls, float maxRadius,
-                             float delta, float maxSpeed, std::vector<LveModel::Vertex> &vertices)
+                             float delta, float maxSpeed)
     {
-        // // very random seed
-        // srand(time(NULL));
-        // std::mt19937_64 rng;
-        // uint64_t timeSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        // std::seed_seq ss{uint32_t(timeSeed & 0xffffffff), uint32_t(timeSeed >> 32)};
-        // rng.seed(ss);
-
-        // std::uniform_real_distribution<double> unif(-1 + maxRadius + delta, 1 - maxRadius - delta);
-        // std::uniform_real_distribution<double> unifSpeed(-maxSpeed, maxSpeed);
-        // std::uniform_real_distribution<double> unifColor(0, 1);
-        // std::vector<glm::vec2> positions;
-        // std::uniform_real_distribution<double> unifRadius(0.3 * maxRadius, maxRadius);
-
-        // for (int i = 0; i < numOfBalls; i++)
-        // {
-
-        //     float xSpeed = unifSpeed(rng);
-        //     float ySpeed = unifSpeed(rng);
-
-        //     float xPos, yPos;
-        //     int occuCounter = 0;
-
-        //     xPos = unif(rng);
-        //     yPos = unif(rng);
-
-        //     if (positions.empty())
-        //     {
-        //         positions.push_back({xPos, yPos});
-        //     }
-        //     else
-        //     {
-        //         while (checkIfOccupided(xPos, yPos, positions, maxRadius, delta) && occuCounter <= 10)
-        //         {
-        //             occuCounter++;
-        //             xPos = unif(rng);
-        //             yPos = unif(rng);
-        //         }
-        //         positions.push_back({xPos, yPos});
-        //     }
-
-        //     float r = unifColor(rng);
-        //     float g = unifColor(rng);
-        //     float b = unifColor(rng);
-        //     //    float r = 1.0f;
-        //     //    float g = 1.0f;
-        //     //    float b = 1.0f;
-        //     float radius = unifRadius(rng);
-
-        //     vertices.clear();
-        //     makeCircle({{0.0f, 0.0f}}, radius, 0.1, &vertices);
-        //     auto lveModel = std::make_shared<LveModel>(lveDevice, vertices);
-        //     auto circle = LveGameObject::createGameObject();
-
-        //     circle.model = lveModel;
-        //     circle.color = {r, g, b};
-        //     circle.speedVec = {xSpeed, ySpeed};
-        //     circle.tranform2d.translation.x = xPos;
-        //     circle.tranform2d.translation.y = yPos;
-        //     //  circle.tranform2d.scale = {1.0f, WIDTH/HEIGHT};
-        //     circle.mass = radius;
-        //     circle.radius = radius;
-
-        //     if (occuCounter < 10)
-        //     {
-        //         gameObjects.push_back(std::move(circle));
-        //     }
-        //     else
-        //     {
-        //         std::cout << "cant add this object no space " << std::endl;
-        //     }
-        // }
+        // very random seed
+        std::mt19937_64 rng;
+        uint64_t timeSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        std::seed_seq ss{uint32_t(timeSeed & 0xffffffff), uint32_t(timeSeed >> 32)};
+        rng.seed(ss);
+
+        std::uniform_real_distribution<double> unifSpeed(-maxSpeed, maxSpeed);
+        std::uniform_real_distribution<double> unifRadius(0.3 * maxRadius, maxRadius);
+
+        // centres far enough apart for two of the largest balls plus delta
+        const float border = 1 - maxRadius - delta;
+        LvePoissonDisk spawner{-border, -border, border, border, 2 * maxRadius + delta};
+        std::vector<glm::vec2> positions = spawner.sample(numOfBalls, rng);
+        if (positions.size() < static_cast<size_t>(numOfBalls))
+        {
+            std::cout << "only " << positions.size() << " of " << numOfBalls << " balls fit in the arena" << std::endl;
+        }
+
+        // every ball shares one unit circle, the radius is applied through the scale
+        std::shared_ptr<LveModel> circleModel = modelCache.getUnitCircle(0.1f);
+        for (auto position : positions)
+        {
+            float xSpeed = unifSpeed(rng);
+            float ySpeed = unifSpeed(rng);
+            float radius = unifRadius(rng);
+
+            auto circle = LveGameObject::createGameObject();
+
+            circle.model = circleModel;
+            circle.transform.translation = {position.x, position.y, BALL_PLANE_Z};
+            circle.transform.scale = {radius, radius, 1.0f};
+            circle.ballIndex = balls.add(position.x, position.y, xSpeed, ySpeed, radius, radius);
+            gameObjects.push_back(std::move(circle));
+        }
+    }
+
+    void FirstApp::updateBallObjects(const PhysicsSystem& physics, float alpha)
+    {
+        // draws the balls between the last two physics steps, alpha is how far into the next step the frame is
+        for (auto& obj : gameObjects)
+        {
+            if (obj.ballIndex < 0)
+            {
+                continue;
+            }
+            obj.transform.translation.x = glm::mix(balls.prevX[obj.ballIndex], balls.x[obj.ballIndex], alpha);
+            obj.transform.translation.y = glm::mix(balls.prevY[obj.ballIndex], balls.y[obj.ballIndex], alpha);
+            obj.color = physics.getColorFromSpeed(obj.ballIndex);
+        }
     }
 
 std::unique_ptr<LveModel> createCubeModel(LveDevice& device, glm::vec3 offset) {
@@ -217,13 +283,16 @@ std::unique_ptr<LveModel> createCubeModel(LveDevice& device, glm::vec3 offset) {
   for (auto& v : vertices) {
     v.position += offset;
   }
-  return std::make_unique<LveModel>(device, vertices);
+  // the builder merges the corners each face repeats
+  LveModel::Builder builder{};
+  builder.vertices = vertices;
+  return std::make_unique<LveModel>(device, builder);
 }
 
     void FirstApp::loadGameObjects()
     {
-        //
-        std::vector<LveModel::Vertex> vertices;
+        // every model's vertices go up in a single submission
+        lveDevice.beginUploadBatch();
         std::shared_ptr<LveModel> lveModel = createCubeModel(lveDevice, {.0f, .0f, .0f});
   auto cube = LveGameObject::createGameObject();
   cube.model = lveModel;
@@ -231,6 +300,10 @@ std::unique_ptr<LveModel> createCubeModel(LveDevice& device, glm::vec3 offset) {
   cube.transform.scale = {.5f, .5f, .5f};
   gameObjects.push_back(std::move(cube));
 
+        // max speed in arena units per second
+        loadBalls(200, 0.04f, 0.005f, 0.24f);
+
+        lveDevice.endUploadBatch();
     }
 
 }
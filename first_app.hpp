@@ -3,19 +3,46 @@
 #include "lve_window.hpp"
 #include "lve_device.hpp"
 #include "lve_model.hpp"
+#include "lve_model_cache.hpp"
 #include "lve_game_object.hpp"
 #include "lve_renderer.hpp"
+#include "lve_ball_store.hpp"
+#include "lve_ball_physics.hpp"
 
 
 #include <memory>
+#include <thread>
 #include <vector>
 namespace lve{
     class FirstApp{
         public:
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
+        // depth of the plane the ball arena is drawn on, in front of the perspective camera
+        static constexpr float BALL_PLANE_Z = 3.0f;
+        // physics runs at a fixed rate independent of the present rate
+        static constexpr float PHYSICS_STEP = 1.0f / 240.0f;
+        // frames slower than this many steps drop simulation time instead of falling further behind
+        static constexpr int MAX_PHYSICS_STEPS_PER_FRAME = 8;
+        // GpuCulled culls on the GPU and issues one indirect draw per model, Instanced culls on
+        // the CPU and issues one instanced draw per model, it is used when the GPU culling
+        // pipeline cannot be built. Parallel culls on the CPU and records one draw per object
+        // on every core, Serial does the same on the render thread. Both sort their draws
+        // through the render queue
+        enum class RenderPath{ GpuCulled, Instanced, Parallel, Serial };
+        // draw objects in their own colour, balls by speed, instead of their vertex colours
+        static constexpr bool OBJECT_COLORS = false;
 
-        FirstApp();
+        struct Options{
+            RenderPath renderPath{RenderPath::GpuCulled};
+            // prints the gpu memory use once the scene is loaded and frame statistics once a second
+            bool printStats{false};
+            // workers of the physics step and the parallel recorder, 0 runs the ordered
+            // single-threaded physics step
+            unsigned threads{std::thread::hardware_concurrency()};
+        };
+
+        explicit FirstApp(const Options &options);
         ~FirstApp();
 
         FirstApp(const FirstApp&) = delete;
@@ -30,12 +57,16 @@ namespace lve{
              void makeCircle(LveModel::Vertex center, float radius, float angle, std::vector<LveModel::Vertex> *vertices, glm::vec3 color);
 
              void FillVert(LveModel::Vertex center, float size, std::vector<LveModel::Vertex> *vertices, int depth);
-           void loadBalls(int numOfBalls, float radius, float delta, float maxSpeed, std::vector<LveModel::Vertex> &vertices);
+           void loadBalls(int numOfBalls, float radius, float delta, float maxSpeed);
            void makeAlmostSpehere(LveModel::Vertex center, float radius, float angle, std::vector<LveModel::Vertex> *vertices);
+           void updateBallObjects(const PhysicsSystem& physics, float alpha);
 
+            Options options;
             LveWindow lveWindow{WIDTH, HEIGHT, "Vulkan tutorial!"};
             LveDevice lveDevice{lveWindow};
             LveRenderer lveRenderer{lveWindow, lveDevice};
+            LveModelCache modelCache{lveDevice};
             std::vector<LveGameObject> gameObjects;
+            LveBallStore balls;
     };
 }
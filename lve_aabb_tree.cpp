@@ -0,0 +1,322 @@
+#include "lve_aabb_tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace lve{
+
+    static LveAabb combine(const LveAabb& a, const LveAabb& b){
+        return {std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+    }
+
+    LveAabbTree::LveAabbTree(float margin) : margin{margin}{}
+
+    int32_t LveAabbTree::allocateNode(){
+        if(freeList == NULL_NODE){
+            nodes.push_back({});
+            nodes.back().parent = NULL_NODE;
+            nodes.back().height = -1;
+            freeList = static_cast<int32_t>(nodes.size()) - 1;
+        }
+        int32_t node = freeList;
+        freeList = nodes[node].parent;
+        nodes[node].parent = NULL_NODE;
+        nodes[node].child1 = NULL_NODE;
+        nodes[node].child2 = NULL_NODE;
+        nodes[node].height = 0;
+        nodes[node].userData = 0;
+        return node;
+    }
+
+    void LveAabbTree::freeNode(int32_t node){
+        nodes[node].parent = freeList;
+        nodes[node].height = -1;
+        freeList = node;
+    }
+
+    void LveAabbTree::clear(){
+        nodes.clear();
+        root = NULL_NODE;
+        freeList = NULL_NODE;
+        proxyCount = 0;
+    }
+
+    int32_t LveAabbTree::createProxy(const LveAabb& box, uint32_t userData){
+        int32_t proxy = allocateNode();
+        nodes[proxy].box = {box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin};
+        nodes[proxy].userData = userData;
+        insertLeaf(proxy);
+        proxyCount++;
+        return proxy;
+    }
+
+    void LveAabbTree::destroyProxy(int32_t proxy){
+        assert(nodes[proxy].isLeaf() && "Only leaves are proxies");
+        removeLeaf(proxy);
+        freeNode(proxy);
+        proxyCount--;
+    }
+
+    bool LveAabbTree::moveProxy(int32_t proxy, const LveAabb& box, float displacementX, float displacementY){
+        assert(nodes[proxy].isLeaf() && "Only leaves are proxies");
+        if(nodes[proxy].box.contains(box)){
+            return false;
+        }
+
+        removeLeaf(proxy);
+        // stretching the box along the expected motion keeps a steadily moving object in
+        // the same leaf for several steps
+        LveAabb fat{box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin};
+        const float predict = 2.0f;
+        if(displacementX < 0.0f){
+            fat.minX += predict * displacementX;
+        }
+        else{
+            fat.maxX += predict * displacementX;
+        }
+        if(displacementY < 0.0f){
+            fat.minY += predict * displacementY;
+        }
+        else{
+            fat.maxY += predict * displacementY;
+        }
+        nodes[proxy].box = fat;
+        insertLeaf(proxy);
+        return true;
+    }
+
+    void LveAabbTree::insertLeaf(int32_t leaf){
+        if(root == NULL_NODE){
+            root = leaf;
+            nodes[root].parent = NULL_NODE;
+            return;
+        }
+
+        // walk down to the sibling that grows the total perimeter of the tree the least
+        const LveAabb leafBox = nodes[leaf].box;
+        int32_t index = root;
+        while(!nodes[index].isLeaf()){
+            int32_t child1 = nodes[index].child1;
+            int32_t child2 = nodes[index].child2;
+
+            float area = nodes[index].box.perimeter();
+            float combinedArea = combine(nodes[index].box, leafBox).perimeter();
+            // cost of pairing the leaf with this node, and the cost pushed down to the children
+            float cost = 2.0f * combinedArea;
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t child){
+                float childCost = combine(leafBox, nodes[child].box).perimeter();
+                if(!nodes[child].isLeaf()){
+                    childCost -= nodes[child].box.perimeter();
+                }
+                return childCost + inheritanceCost;
+            };
+            float cost1 = descendCost(child1);
+            float cost2 = descendCost(child2);
+
+            if(cost < cost1 && cost < cost2){
+                break;
+            }
+            index = cost1 < cost2 ? child1 : child2;
+        }
+        int32_t sibling = index;
+
+        int32_t oldParent = nodes[sibling].parent;
+        int32_t newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = combine(leafBox, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if(oldParent == NULL_NODE){
+            root = newParent;
+        }
+        else if(nodes[oldParent].child1 == sibling){
+            nodes[oldParent].child1 = newParent;
+        }
+        else{
+            nodes[oldParent].child2 = newParent;
+        }
+
+        refitAncestors(nodes[leaf].parent);
+    }
+
+    void LveAabbTree::removeLeaf(int32_t leaf){
+        if(leaf == root){
+            root = NULL_NODE;
+            return;
+        }
+
+        int32_t parent = nodes[leaf].parent;
+        int32_t grandParent = nodes[parent].parent;
+        int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        // the sibling takes the parent's place
+        if(grandParent == NULL_NODE){
+            root = sibling;
+            nodes[sibling].parent = NULL_NODE;
+            freeNode(parent);
+            return;
+        }
+        if(nodes[grandParent].child1 == parent){
+            nodes[grandParent].child1 = sibling;
+        }
+        else{
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refitAncestors(grandParent);
+    }
+
+    void LveAabbTree::refitAncestors(int32_t node){
+        while(node != NULL_NODE){
+            node = balance(node);
+            int32_t child1 = nodes[node].child1;
+            int32_t child2 = nodes[node].child2;
+            nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+            nodes[node].box = combine(nodes[child1].box, nodes[child2].box);
+            node = nodes[node].parent;
+        }
+    }
+
+    // If one child of a is two levels higher than the other, the higher child is rotated up
+    // into a's place and a takes its shorter grandchild. Returns the node now at a's place.
+    int32_t LveAabbTree::balance(int32_t a){
+        if(nodes[a].isLeaf() || nodes[a].height < 2){
+            return a;
+        }
+
+        int32_t b = nodes[a].child1;
+        int32_t c = nodes[a].child2;
+        int32_t heightDifference = nodes[c].height - nodes[b].height;
+        if(heightDifference < -1){
+            std::swap(b, c);
+        }
+        else if(heightDifference <= 1){
+            return a;
+        }
+        // c is the higher child from here on, b the other one
+        int32_t f = nodes[c].child1;
+        int32_t g = nodes[c].child2;
+
+        // c takes a's place
+        nodes[c].child1 = a;
+        nodes[c].parent = nodes[a].parent;
+        nodes[a].parent = c;
+        if(nodes[c].parent == NULL_NODE){
+            root = c;
+        }
+        else if(nodes[nodes[c].parent].child1 == a){
+            nodes[nodes[c].parent].child1 = c;
+        }
+        else{
+            nodes[nodes[c].parent].child2 = c;
+        }
+
+        // the higher grandchild stays under c, the other one moves under a
+        if(nodes[f].height < nodes[g].height){
+            std::swap(f, g);
+        }
+        nodes[c].child2 = f;
+        if(nodes[a].child1 == b){
+            nodes[a].child2 = g;
+        }
+        else{
+            nodes[a].child1 = g;
+        }
+        nodes[g].parent = a;
+
+        nodes[a].box = combine(nodes[b].box, nodes[g].box);
+        nodes[a].height = 1 + std::max(nodes[b].height, nodes[g].height);
+        nodes[c].box = combine(nodes[a].box, nodes[f].box);
+        nodes[c].height = 1 + std::max(nodes[a].height, nodes[f].height);
+        return c;
+    }
+
+    void LveAabbTree::query(const LveAabb& box, std::vector<uint32_t>& out) const{
+        if(root == NULL_NODE){
+            return;
+        }
+        if(!nodes[root].box.overlaps(box)){
+            return;
+        }
+        // only nodes that overlap the box are pushed
+        int32_t stack[MAX_QUERY_DEPTH];
+        int count = 0;
+        stack[count++] = root;
+        while(count > 0){
+            const Node& node = nodes[stack[--count]];
+            if(node.isLeaf()){
+                out.push_back(node.userData);
+                continue;
+            }
+            if(count + 2 > MAX_QUERY_DEPTH){
+                throw std::runtime_error("aabb tree is too deep to query");
+            }
+            if(nodes[node.child1].box.overlaps(box)){
+                stack[count++] = node.child1;
+            }
+            if(nodes[node.child2].box.overlaps(box)){
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+    void LveAabbTree::rayCast(float fromX, float fromY, float toX, float toY, std::vector<uint32_t>& out, float thickness) const{
+        if(root == NULL_NODE){
+            return;
+        }
+        const float dirX = toX - fromX;
+        const float dirY = toY - fromY;
+        const LveAabb segmentBox{std::min(fromX, toX) - thickness, std::min(fromY, toY) - thickness,
+            std::max(fromX, toX) + thickness, std::max(fromY, toY) + thickness};
+
+        // slab test of the segment against a box, parameters 0 and 1 are the two ends
+        auto crosses = [&](LveAabb box){
+            box = {box.minX - thickness, box.minY - thickness, box.maxX + thickness, box.maxY + thickness};
+            if(!box.overlaps(segmentBox)){
+                return false;
+            }
+            float enter = 0.0f, leave = 1.0f;
+            auto slab = [&](float from, float dir, float min, float max){
+                if(dir == 0.0f){
+                    return from >= min && from <= max;
+                }
+                float t1 = (min - from) / dir;
+                float t2 = (max - from) / dir;
+                enter = std::max(enter, std::min(t1, t2));
+                leave = std::min(leave, std::max(t1, t2));
+                return enter <= leave;
+            };
+            return slab(fromX, dirX, box.minX, box.maxX) && slab(fromY, dirY, box.minY, box.maxY);
+        };
+
+        int32_t stack[MAX_QUERY_DEPTH];
+        int count = 0;
+        stack[count++] = root;
+        while(count > 0){
+            const Node& node = nodes[stack[--count]];
+            if(!crosses(node.box)){
+                continue;
+            }
+            if(node.isLeaf()){
+                out.push_back(node.userData);
+            }
+            else{
+                if(count + 2 > MAX_QUERY_DEPTH){
+                    throw std::runtime_error("aabb tree is too deep to query");
+                }
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+}
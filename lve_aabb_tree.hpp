@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve{
+
+    struct LveAabb{
+        float minX, minY, maxX, maxY;
+
+        bool overlaps(const LveAabb& other) const{
+            return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+        }
+        bool contains(const LveAabb& other) const{
+            return minX <= other.minX && minY <= other.minY && other.maxX <= maxX && other.maxY <= maxY;
+        }
+        float perimeter() const{return 2.0f * ((maxX - minX) + (maxY - minY));}
+    };
+
+    // Dynamic bounding volume hierarchy over axis aligned boxes. Every leaf stores a box
+    // fattened by a margin and by the predicted motion, so a leaf is only reinserted
+    // when its object leaves the fat box. Inner nodes are kept balanced with rotations,
+    // which keeps queries logarithmic no matter how different the box sizes are.
+    class LveAabbTree{
+        public:
+        static constexpr int32_t NULL_NODE = -1;
+        // traversal stack of a query, a balanced tree this deep would hold far more boxes than memory
+        static constexpr int MAX_QUERY_DEPTH = 256;
+
+        explicit LveAabbTree(float margin = 0.01f);
+
+        // returns the proxy id used by the other calls
+        int32_t createProxy(const LveAabb& box, uint32_t userData);
+        void destroyProxy(int32_t proxy);
+        // displacement is the motion expected until the next move, the fat box is stretched
+        // in that direction. Returns true when the proxy had to be reinserted
+        bool moveProxy(int32_t proxy, const LveAabb& box, float displacementX, float displacementY);
+        void clear();
+
+        uint32_t getUserData(int32_t proxy) const{return nodes[proxy].userData;}
+        const LveAabb& getFatAabb(int32_t proxy) const{return nodes[proxy].box;}
+        int getHeight() const{return root == NULL_NODE ? 0 : nodes[root].height;}
+        size_t getProxyCount() const{return proxyCount;}
+
+        // appends the user data of every leaf whose fat box overlaps box
+        void query(const LveAabb& box, std::vector<uint32_t>& out) const;
+        // appends the user data of every leaf whose fat box, grown by thickness, the segment
+        // from (fromX, fromY) to (toX, toY) crosses, in no particular order
+        void rayCast(float fromX, float fromY, float toX, float toY, std::vector<uint32_t>& out, float thickness = 0.0f) const;
+
+        private:
+            struct Node{
+                LveAabb box;
+                // next free node while the node is unused
+                int32_t parent;
+                int32_t child1, child2;
+                // 0 for leaves, -1 for free nodes
+                int32_t height;
+                uint32_t userData;
+
+                bool isLeaf() const{return child1 == NULL_NODE;}
+            };
+
+            int32_t allocateNode();
+            void freeNode(int32_t node);
+            void insertLeaf(int32_t leaf);
+            void removeLeaf(int32_t leaf);
+            int32_t balance(int32_t node);
+            void refitAncestors(int32_t node);
+
+            float margin;
+            int32_t root{NULL_NODE};
+            int32_t freeList{NULL_NODE};
+            size_t proxyCount{0};
+            std::vector<Node> nodes;
+    };
+}
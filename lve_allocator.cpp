@@ -0,0 +1,184 @@
+#include "lve_allocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace lve{
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    LveAllocator::LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : device{device}{
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    }
+
+    LveAllocator::~LveAllocator(){
+        for(auto& block : blocks){
+            vkFreeMemory(device, block.memory, nullptr);
+        }
+    }
+
+    VkDeviceSize LveAllocator::blockSize(uint32_t memoryType) const{
+        // small heaps, like the host visible part of device memory, are not spent on one block
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        return std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+    }
+
+    VkDeviceMemory LveAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryType, void **mapped){
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory;
+        if(vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+        *mapped = nullptr;
+        if(memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT){
+            if(vkMapMemory(device, memory, 0, size, 0, mapped) != VK_SUCCESS){
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+        return memory;
+    }
+
+    bool LveAllocator::allocateFromBlock(int32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, LveAllocation &allocation){
+        Block& block = blocks[blockIndex];
+        auto best = block.freeRanges.end();
+        VkDeviceSize bestSize = 0;
+        for(auto range = block.freeRanges.begin(); range != block.freeRanges.end(); ++range){
+            VkDeviceSize offset = alignUp(range->first, alignment);
+            VkDeviceSize end = range->first + range->second;
+            if(offset + size <= end && (best == block.freeRanges.end() || range->second < bestSize)){
+                best = range;
+                bestSize = range->second;
+            }
+        }
+        if(best == block.freeRanges.end()){
+            return false;
+        }
+
+        // the padding in front of the aligned offset and the rest behind it stay free
+        VkDeviceSize rangeOffset = best->first;
+        VkDeviceSize rangeEnd = best->first + best->second;
+        VkDeviceSize offset = alignUp(rangeOffset, alignment);
+        block.freeRanges.erase(best);
+        if(offset > rangeOffset){
+            block.freeRanges.emplace(rangeOffset, offset - rangeOffset);
+        }
+        if(offset + size < rangeEnd){
+            block.freeRanges.emplace(offset + size, rangeEnd - offset - size);
+        }
+        block.usedBytes += size;
+        block.allocationCount++;
+
+        allocation.memory = block.memory;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+        allocation.block = blockIndex;
+        return true;
+    }
+
+    LveAllocation LveAllocator::allocate(const VkMemoryRequirements &requirements, uint32_t memoryType, bool linear){
+        std::lock_guard<std::mutex> lock{mutex};
+        LveAllocation allocation{};
+        const VkDeviceSize size = std::max<VkDeviceSize>(requirements.size, 1);
+        const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        const VkDeviceSize newBlockSize = blockSize(memoryType);
+
+        if(size > newBlockSize / 2){
+            allocation.memory = allocateMemory(size, memoryType, &allocation.mapped);
+            allocation.size = size;
+            allocation.block = -1;
+            dedicatedAllocationCount++;
+            dedicatedBytes += size;
+            return allocation;
+        }
+
+        for(size_t i = 0; i < blocks.size(); i++){
+            if(blocks[i].memoryType != memoryType || blocks[i].linear != linear){
+                continue;
+            }
+            if(allocateFromBlock(static_cast<int32_t>(i), size, alignment, allocation)){
+                return allocation;
+            }
+        }
+
+        Block block{};
+        block.memory = allocateMemory(newBlockSize, memoryType, &block.mapped);
+        block.size = newBlockSize;
+        block.memoryType = memoryType;
+        block.linear = linear;
+        block.freeRanges.emplace(0, newBlockSize);
+        blocks.push_back(std::move(block));
+        allocateFromBlock(static_cast<int32_t>(blocks.size()) - 1, size, alignment, allocation);
+        return allocation;
+    }
+
+    void LveAllocator::free(LveAllocation &allocation){
+        if(allocation.memory == VK_NULL_HANDLE){
+            return;
+        }
+        std::lock_guard<std::mutex> lock{mutex};
+        if(allocation.block < 0){
+            vkFreeMemory(device, allocation.memory, nullptr);
+            dedicatedAllocationCount--;
+            dedicatedBytes -= allocation.size;
+            allocation = {};
+            return;
+        }
+
+        Block& block = blocks[allocation.block];
+        VkDeviceSize offset = allocation.offset;
+        VkDeviceSize size = allocation.size;
+        block.usedBytes -= size;
+        block.allocationCount--;
+
+        // merge with the free ranges right before and after it
+        auto next = block.freeRanges.lower_bound(offset);
+        if(next != block.freeRanges.begin()){
+            auto prev = std::prev(next);
+            if(prev->first + prev->second == offset){
+                offset = prev->first;
+                size += prev->second;
+                block.freeRanges.erase(prev);
+            }
+        }
+        if(next != block.freeRanges.end() && offset + size == next->first){
+            size += next->second;
+            block.freeRanges.erase(next);
+        }
+        block.freeRanges.emplace(offset, size);
+        allocation = {};
+    }
+
+    LveAllocator::Stats LveAllocator::getStats() const{
+        std::lock_guard<std::mutex> lock{mutex};
+        Stats stats{};
+        for(auto& block : blocks){
+            stats.blockCount++;
+            stats.allocationCount += block.allocationCount;
+            stats.reservedBytes += block.size;
+            stats.usedBytes += block.usedBytes;
+            stats.freeRangeCount += block.freeRanges.size();
+            VkDeviceSize largest = 0;
+            for(auto& range : block.freeRanges){
+                stats.freeBytes += range.second;
+                largest = std::max(largest, range.second);
+            }
+            stats.largestFreeRange = std::max(stats.largestFreeRange, largest);
+            stats.largestFreeRangePerBlock += largest;
+        }
+        stats.dedicatedAllocationCount = dedicatedAllocationCount;
+        stats.deviceAllocationCount = stats.blockCount + dedicatedAllocationCount;
+        stats.allocationCount += dedicatedAllocationCount;
+        stats.reservedBytes += dedicatedBytes;
+        stats.usedBytes += dedicatedBytes;
+        return stats;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace lve{
+
+    // a range of device memory handed out by LveAllocator, resources are bound at offset
+    struct LveAllocation{
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+        // host address of offset while the memory is host visible, nullptr otherwise.
+        // Blocks stay mapped, so the range must not be mapped again with vkMapMemory
+        void *mapped{nullptr};
+        // block the range was carved from, -1 for a dedicated allocation
+        int32_t block{-1};
+    };
+
+    // Reserves large blocks of device memory per memory type and hands out aligned ranges of
+    // them, so the number of vkAllocateMemory calls stays far below maxMemoryAllocationCount.
+    // Every block keeps its free ranges sorted by offset, allocations take the smallest range
+    // that fits and freed ranges merge with their free neighbours. Requests larger than half a
+    // block get a dedicated allocation. Blocks are kept until the allocator is destroyed.
+    class LveAllocator{
+        public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = VkDeviceSize{64} << 20;
+
+        struct Stats{
+            // blocks plus dedicated allocations, what counts against maxMemoryAllocationCount
+            uint32_t deviceAllocationCount{0};
+            uint32_t blockCount{0};
+            uint32_t dedicatedAllocationCount{0};
+            size_t allocationCount{0};
+            // bytes reserved from the driver, of those handed out, and free inside blocks
+            VkDeviceSize reservedBytes{0};
+            VkDeviceSize usedBytes{0};
+            VkDeviceSize freeBytes{0};
+            size_t freeRangeCount{0};
+            VkDeviceSize largestFreeRange{0};
+            // largest free range of every block added up
+            VkDeviceSize largestFreeRangePerBlock{0};
+
+            // 0 while the free space of every block is one range, towards 1 the more it is
+            // split into ranges too small for a larger request
+            float fragmentation() const{
+                return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeRangePerBlock) / freeBytes;
+            }
+        };
+
+        LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+        ~LveAllocator();
+
+        LveAllocator(const LveAllocator&) = delete;
+        LveAllocator &operator=(const LveAllocator &) = delete;
+
+        // linear is true for buffers and linearly tiled images. They never share a block with
+        // optimally tiled images, which keeps bufferImageGranularity out of the alignment
+        LveAllocation allocate(const VkMemoryRequirements &requirements, uint32_t memoryType, bool linear);
+        void free(LveAllocation &allocation);
+
+        Stats getStats() const;
+
+        private:
+            struct Block{
+                VkDeviceMemory memory{VK_NULL_HANDLE};
+                VkDeviceSize size{0};
+                void *mapped{nullptr};
+                uint32_t memoryType{0};
+                bool linear{true};
+                // offset to size of every free range
+                std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+                VkDeviceSize usedBytes{0};
+                size_t allocationCount{0};
+            };
+
+            VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryType, void **mapped);
+            VkDeviceSize blockSize(uint32_t memoryType) const;
+            // false when no free range of the block fits the request
+            bool allocateFromBlock(int32_t blockIndex, VkDeviceSize size, VkDeviceSize alignment, LveAllocation &allocation);
+
+            VkDevice device;
+            VkPhysicalDeviceMemoryProperties memoryProperties;
+            mutable std::mutex mutex;
+            std::vector<Block> blocks;
+            uint32_t dedicatedAllocationCount{0};
+            VkDeviceSize dedicatedBytes{0};
+    };
+}
@@ -1,357 +1,783 @@
-// #include "lve_ball_physics.hpp"
-// #include <iostream>
-// #include <cmath>
-// namespace lve
-// {
-
-//     PhysicsSystem::PhysicsSystem(std::vector<LveGameObject>& gameObjects):gameObjects(gameObjects){};
-
-//     void PhysicsSystem::update()
-//     {
-//         static std::vector<int> escaped;
-//         calcMinMaxSpeed();
-       
-//         //std::cout << "min speed: "<<minSpeed << ", max speed: "<<maxSpeed << std::endl;
-//         for (auto &obj : gameObjects)
-//         {
-                
-//             if (checkIfCollidedWithWall(obj))
-//             {
-
-//                 //    // obj.speed *= 0.93f;
-//             }
-
-//             for (auto &otherObj : gameObjects)
-//             {
-//                 if (obj.getId() != otherObj.getId())
-//                 {
-//                     if (checkIfCollidedAndUpdate(obj, otherObj))
-//                     {
-//                     }
-//                 }
-//             }
-
-//             obj.tranform2d.translation.x += obj.speedVec.x;
-//             obj.tranform2d.translation.y += obj.speedVec.y;
-//             obj.color = getColorFromSpeed(obj);
-
-
-//             if (obj.tranform2d.translation.x > 1 || obj.tranform2d.translation.x < -1 ||
-//                 obj.tranform2d.translation.y > 1 || obj.tranform2d.translation.y < -1)
-//             {
-
-//                 bool inside = false;
-//                 if (!escaped.empty())
-//                 {
-
-//                     for (auto &o : escaped)
-//                     {
-//                         if (obj.getId() == o)
-//                         {
-//                             inside = true;
-//                             break;
-//                         }
-//                     }
-//                 }
-//                 if (!inside)
-//                 {
-//                     escaped.push_back(obj.getId());
-//                     std::cout << "object [" << obj.getId() << "] escaped, pos: {"
-//                               << obj.tranform2d.translation.x << ", "
-//                               << obj.tranform2d.translation.y << "}"
-//                               << ", speed : " << obj.getSpeed() << ", escaped count: " << escaped.size()
-//                               << std::endl;
-//                 }
-//             }
-//         }
-//     }
-
-//     // void PhysicsSystem::adjustForWall(LveGameObject &obj){
-//     //        if (obj.tranform2d.translation.x + obj.radius > 1.0f)
-//     //                 {
-//     //                     obj.speedVec.x *= -1.0f;
-
-//     //                     obj.tranform2d.translation.x += obj.speedVec.x ;
-//     //                 }
-//     //                 if (obj.tranform2d.translation.x - obj.radius < -1.0f)
-//     //                 {
-//     //                     obj.speedVec.x *= -1.0f;
-
-//     //                     obj.tranform2d.translation.x += obj.speedVec.x ;
-//     //                 }
-//     //                 if (obj.tranform2d.translation.y + obj.radius > 1.0f)
-//     //                 {
-//     //                     obj.speedVec.y *= -1.0f;
-
-//     //                     obj.tranform2d.translation.y += obj.speedVec.y ;
-//     //                 }
-//     //                 if (obj.tranform2d.translation.y - obj.radius < -1.0f)
-//     //                 {
-//     //                     obj.speedVec.y *= -1.0f;
-
-//     //                     obj.tranform2d.translation.y += obj.speedVec.y ;
-//     //                 }
-//     // }
-
-//     void PhysicsSystem::updateSpeedForWallCollision(LveGameObject& obj, std::string wall){
-//         float theta;
-
-//         float x1 =obj.speedVec.x;
-//        float y1 =obj.speedVec.y;
-     
-//        float alpha = atan(y1/x1);
-//        checkQuadrant(x1, y1, alpha);
-//         if(wall=="rightWall" || wall =="leftWall"){
-//           theta= 0;
-//         }else if( wall=="upperWall" || wall=="bottomWall"){
-            
-//               theta = M_PI /2;
-//         }
-//         else{
-//             throw std::runtime_error("That wall doesn't exist : " +wall);
-//         }
-
-
-//         //std::cout <<"alpha: "<<alpha<< ", theta: "<< theta <<std::endl;
-//         float vx1 = (((obj.getSpeed()* cos(alpha-theta))*(obj.mass-10000.0f) )
-//                              / (obj.mass + 10000.0f))* cos(theta) 
-//                              + obj.getSpeed()*sin(alpha-theta)*cos(theta+(M_PI/2));
-
-//         float vy1 = (((obj.getSpeed()* cos(alpha-theta))*(obj.mass-10000.0f)  )
-//                              / (obj.mass + 10000.0f))* sin(theta) 
-//                              + obj.getSpeed()*sin(alpha-theta)*sin(theta+(M_PI/2));
-//        //  std::cout <<"speed before : {" <<x1<< ", "<<y1<< "}, speed after: {"<<vx1<< ", "<<vy1<<"} \n";
-//         obj.speedVec = {vx1, vy1};
-//     }
-    
-//    bool PhysicsSystem::checkIfCollidedWithWall(LveGameObject& object1){
-//  //problem je ako ide prebrzo i prođe zid i promjeni mu se na jedan frame brzina, ali onda opet sljedeći
-//         //frame opet je u zidu i promjeni mu se opet
-//          float radius = object1.radius;
-//         float posX = object1.tranform2d.translation.x;
-//         float posY = object1.tranform2d.translation.y;
-  
-
-//          float nextPosX = object1.tranform2d.translation.x +object1.speedVec.x ;
-//         float nextPosY = object1.tranform2d.translation.y +object1.speedVec.y  ;
-
-
-//          //posX+radius >= 1.0f  ||
-//         if( nextPosX+radius >= 1.0f   ) {
-//             if(object1.lastWallHit != "rightWall" || object1.lastHit != object1.getId()){
- 
-//             object1.lastWallHit="rightWall";
-//             object1.lastHit = object1.getId();
-//              //object1.speedVec.x *= -1.0f;
-//             updateSpeedForWallCollision(object1, "rightWall");
-
-          
-//             return true;
-//             }
-//         }//posX-radius <= -1.0f
-//         else if(   nextPosX-radius <= -1.0f){
-//             if(object1.lastWallHit != "leftWall" || object1.lastHit != object1.getId()){
-
-//                 object1.lastWallHit="leftWall";
-//                 object1.lastHit = object1.getId();
-//                // object1.speedVec.x *= -1.0f;
-//             updateSpeedForWallCollision(object1, "leftWall");
-//             return true;
-//             }
-//         }
-//        //posY +radius >= 1.0f || 
-//         else if( nextPosY+radius >=1.0f){
-//             if(object1.lastWallHit != "upperWall"|| object1.lastHit != object1.getId()){
-
-//             object1.lastWallHit="upperWall";
-//              object1.lastHit = object1.getId();
-//             updateSpeedForWallCollision(object1, "upperWall");
-//           //  object1.speedVec.y *= -1.0f;
-//               return true;
-              
-//             }
-//         }//posY- radius < -1.0f ||
-//         else if(  nextPosY-radius <=-1.0f){
-//             if(object1.lastWallHit != "bottomWall"|| object1.lastHit != object1.getId()){
-
-//             object1.lastWallHit="bottomWall";
-//              object1.lastHit = object1.getId();
-//             updateSpeedForWallCollision(object1, "bottomWall");
-//            // object1.speedVec.y *= -1.0f;
-//               return true;
-              
-//             }
-//         }
-
-//       //}
-       
-
-//         return false;
-//    }
-
-//    void PhysicsSystem::checkQuadrant(float x, float y, float& angle){
-//     //    if(x <0 || y >0){
-//     //        if(!(x<0 && y>0)){
-//     //            angle = M_PI -angle;
-//     //        }
-//     //    }
-
-//     if(x <0){
-//         angle = M_PI +angle;
-//     }
-//    }
-
-// float roundoff(float value, unsigned char prec)
-// {
-//   float pow_10 = pow(10.0f, (float)prec);
-//   return round(value * pow_10) / pow_10;
-// }
-
-//     float calcAngleOfImpact(std::pair<float,float> obj1, std::pair<float,float> obj2){
-       
-//         float x = obj2.first - obj1.first;
-//         float y = obj2.second - obj1.second;
-//        // std::cout <<"x: "<<x << ", y : "<<y<<"\n";
-//         if(fabs(x) < 0.00001f && y >= 0 ){
-//             return M_PI/2;
-//         }
-//         else if(fabs(x) < 0.00001f && y<0){
-//             return (3*M_PI)/2;
-//         }
-//         return atan(y/x);
-//     }
-
-//    void PhysicsSystem::updateVecSpeed(LveGameObject &object1, LveGameObject &object2){
-//        float x1 =object1.speedVec.x;
-//        float y1 =object1.speedVec.y;
-//        float x2 =object2.speedVec.x;
-//        float y2 =object2.speedVec.y;
-//        float alpha1 = atan(y1/x1);
-//        checkQuadrant(x1, y1, alpha1);
-//        float alpha2 = atan(y2/x2);
-//         checkQuadrant(x2, y2, alpha2);
-//       //  std::cout <<"speed angle 1 : "<<alpha1 << "{"<<x1 <<", "<< y1<<"}"<< std::endl;
-//       //  std::cout <<"speed angle 2 : "<<alpha2 << "{"<<x2 <<", "<< y2<<"}"<< std::endl;
-       
-   
-//       float theta = calcAngleOfImpact({object1.tranform2d.translation.x,object1.tranform2d.translation.y },
-//        {object2.tranform2d.translation.x,object2.tranform2d.translation.y});
-//        // std::cout <<" angle of impact : "<<theta  << std::endl;
-
-//       //  std::cout <<"object 1 speed "<< object1.getSpeed() << ", object 2 speed "<<object2.getSpeed() <<"\n";
-//        // std::cout << "object 1  mass : "<<object1.mass << ", object 2 mass : " << object2.mass << "\n";
-//        float vx1 = (((object1.getSpeed()* cos(alpha1-theta))*(object1.mass-object2.mass) + 
-//                                             2*object2.mass*object2.getSpeed()*cos(alpha2-theta))
-//                              / (object1.mass + object2.mass))* cos(theta) 
-//                              + object1.getSpeed()*sin(alpha1-theta)*cos(theta+(M_PI/2));
-
-//         float vy1 = (((object1.getSpeed()* cos(alpha1-theta))*(object1.mass-object2.mass) + 
-//                                             2*object2.mass*object2.getSpeed()*cos(alpha2-theta))
-//                              / (object1.mass + object2.mass))* sin(theta) 
-//                              + object1.getSpeed()*sin(alpha1-theta)*sin(theta+(M_PI/2));
-
-//         float vx2 = (((object2.getSpeed()* cos(alpha2-theta))*(object2.mass-object1.mass) + 
-//                                             2*object1.mass*object1.getSpeed()*cos(alpha1-theta))
-//                              / (object2.mass + object1.mass))* cos(theta) 
-//                              + object2.getSpeed()*sin(alpha2-theta)*cos(theta+(M_PI/2));
-
-//         float vy2 = (((object2.getSpeed()* cos(alpha2-theta))*(object2.mass-object1.mass) + 
-//                                             2*object1.mass*object1.getSpeed()*cos(alpha1-theta))
-//                              / (object2.mass + object1.mass))* sin(theta) 
-//                              + object2.getSpeed()*sin(alpha2-theta)*sin(theta+(M_PI/2));
-
-//    // object1.speedVec = {roundoff(vx1, 5),roundoff(vy1, 5) };
-//     //object2.speedVec = {roundoff(vx2, 5), roundoff(vy2, 5)};
-
-
-//     //std::cout << "vec 1: {"<<vx1 << ", "<<vy1<< "} , it would be: {"<<object2.speedVec.x <<", "<<object2.speedVec.y << "}"<< std::endl;
-//    //  std::cout << "vec 2: {"<<vx2 << ", "<<vy2<< "}, it would be: {"<<object1.speedVec.x <<", "<<object1.speedVec.y << "}"<< std::endl;
-
-
-//      object1.speedVec = {vx1,vy1};
-//    object2.speedVec = {vx2, vy2};
-
-    
-// //    glm::vec2 temp = object1.speedVec;
-// //    object1.speedVec = object2.speedVec;
-// //     object2.speedVec = temp;
-        
-//    }
-//    bool PhysicsSystem::checkIfCollidedAndUpdate(LveGameObject &object1, LveGameObject &object2){
-//          float radiusFirst = object1.radius;
-//          float radiusSecond = object2.radius;
-       
-//         float posX = object1.tranform2d.translation.x;
-//         float posY = object1.tranform2d.translation.y;
-//         float otherPosX = object2.tranform2d.translation.x;
-//         float otherPosY = object2.tranform2d.translation.y;
-
-//         float distance = sqrt(pow(posX-otherPosX, 2.0f) + pow(posY-otherPosY, 2.0f));
-
-
-//         float nextPosX = object1.tranform2d.translation.x +object1.speedVec.x ;
-//         float nextPosY = object1.tranform2d.translation.y +object1.speedVec.y ;
-
-//         float otherNextPosX = object2.tranform2d.translation.x +object2.speedVec.x  ;
-//         float otherNextPosY = object2.tranform2d.translation.y +object2.speedVec.y ;
-  
-//         float distanceNext  = sqrt(pow(nextPosX-otherNextPosX, 2.0f) + pow(nextPosY-otherNextPosY, 2.0f));
-
-
-//         //if (object1.changeCounter > 0 && object2.changeCounter > 0){
-//             //distance <= 2*radius ||
-//             if(object1.lastHit != object2.getId() || object2.lastHit != object1.getId()){
-//             if( distanceNext <= radiusFirst + radiusSecond){
-    
-
-//                 object1.lastHit = object2.getId();
-//                object2.lastHit = object1.getId();
-
-//                updateVecSpeed(object1,object2);
-
-            
-
-
-//                 return true;
-//             }
-//         }
-
-
-//         return false;
-//    }
-
-
-//     glm::vec3 PhysicsSystem::getColorFromSpeed(LveGameObject& obj){
-//         glm::vec3 result;
-     
-        
-
-//         if(maxSpeed - obj.getSpeed()  < obj.getSpeed() - minSpeed){
-//             result.r = (obj.getSpeed() / maxSpeed);
-//             result.b = 0.1f;
-//         }
-//         else{
-//                 result.r = 0.1f;
-//                result.b = (obj.getSpeed() / minSpeed);
-//         }
-        
-//         return result;
-//     }
-
-//     void PhysicsSystem::calcMinMaxSpeed(){
-//         minSpeed = 100.f;
-//         maxSpeed = -1.0f;
-//         for(auto& obj: gameObjects){
-           
-//             if(obj.getSpeed() > maxSpeed){
-//                 maxSpeed = obj.getSpeed();
-//             }
-//             if(obj.getSpeed() < minSpeed){
-//                 minSpeed = obj.getSpeed();
-//             }
-//         }
-
-       
-//     }
-
-//    }
\ No newline at end of file
+#include "lve_ball_physics.hpp"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+namespace lve
+{
+
+    using Wall = LveBallStore::Wall;
+
+    PhysicsSystem::PhysicsSystem(LveBallStore& balls, Broadphase broadphase)
+        : balls(balls), broadphase(broadphase), scratch(1){};
+
+    void PhysicsSystem::update(float stepDt)
+    {
+        dt = stepDt;
+        // balls added since the last step start awake, removing balls forgets all islands
+        if (sleepTime.size() > balls.size())
+        {
+            resetSleep();
+        }
+        sleepTime.resize(balls.size(), 0.0f);
+        sleepingIsland.resize(balls.size(), -1);
+        wokenBalls.clear();
+        calcMinMaxSpeed();
+
+        // positions are moved in place, the broadphase works on the ones from the start of the step
+        balls.prevX = balls.x;
+        balls.prevY = balls.y;
+        stepTime.assign(balls.size(), 0.0f);
+        buildBroadphase();
+        for (auto &workerScratch : scratch)
+        {
+            workerScratch.candidateCount = 0;
+        }
+
+        if (jobPool)
+        {
+            updateParallel();
+        }
+        else
+        {
+            updateSequential();
+        }
+        lastCandidateCount = 0;
+        for (auto &workerScratch : scratch)
+        {
+            lastCandidateCount += workerScratch.candidateCount;
+        }
+        updateSleep();
+        reportEscaped();
+    }
+
+    void PhysicsSystem::setThreadCount(unsigned threadCount)
+    {
+        if (threadCount == 0)
+        {
+            jobPool.reset();
+            return;
+        }
+        jobPool = std::make_unique<LveJobPool>(threadCount);
+        scratch.resize(threadCount);
+    }
+
+    void PhysicsSystem::updateSequential()
+    {
+        //std::cout << "min speed: "<<minSpeed << ", max speed: "<<maxSpeed << std::endl;
+        Scratch &ballScratch = scratch[0];
+        const uint32_t count = static_cast<uint32_t>(balls.size());
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (balls.asleep[i])
+            {
+                continue;
+            }
+            queryCandidates(i, ballScratch);
+            for (size_t k = 0; k < ballScratch.candidates.size(); k++)
+            {
+                gatherCandidate(k, balls.x, balls.y, ballScratch);
+            }
+
+            // every impact moves both balls to its time, so later impacts of this ball and
+            // the balls after it are only looked for from there on
+            for (int impacts = 0; impacts < MAX_IMPACTS_PER_STEP; impacts++)
+            {
+                Wall wall;
+                size_t k;
+                float time = findImpact(sweptCircle(i), ballScratch, wall, k);
+                if (time > dt)
+                {
+                    break;
+                }
+
+                if (wall != Wall::None)
+                {
+                    advance(i, time);
+                    wallCollisionSpeed(balls.vx[i], balls.vy[i], balls.invMass[i], wall, balls.vx[i], balls.vy[i]);
+                    continue;
+                }
+
+                // the other ball's path is only straight up to its next wall, if it gets
+                // there first it bounces and the search starts over with its new path
+                uint32_t other = ballScratch.candidates[k];
+                Wall otherWall;
+                float otherWallTime = wallImpactTime(sweptCircle(other), otherWall);
+                if (otherWallTime < time)
+                {
+                    advance(other, otherWallTime);
+                    wallCollisionSpeed(balls.vx[other], balls.vy[other], balls.invMass[other], otherWall, balls.vx[other], balls.vy[other]);
+                    gatherCandidate(k, balls.x, balls.y, ballScratch);
+                    continue;
+                }
+
+                if (balls.asleep[other])
+                {
+                    wakeIsland(other);
+                }
+                advance(i, time);
+                advance(other, time);
+                collisionSpeeds(balls.x[other] - balls.x[i], balls.y[other] - balls.y[i],
+                    balls.invMass[i], balls.invMass[other],
+                    balls.vx[i], balls.vy[i], balls.vx[other], balls.vy[other]);
+
+                // walls never speed a ball up, so only ball impacts can carry one past what
+                // the broadphase covers. Then it is widened with room for further impacts and
+                // this ball's candidates are found again, the balls after it query the wider one
+                float fastest = std::max(reach(i), reach(other));
+                if (fastest > broadphaseTravel)
+                {
+                    widenBroadphase(2.0f * fastest);
+                    queryCandidates(i, ballScratch);
+                    for (size_t c = 0; c < ballScratch.candidates.size(); c++)
+                    {
+                        gatherCandidate(c, balls.x, balls.y, ballScratch);
+                    }
+                    continue;
+                }
+                gatherCandidate(k, balls.x, balls.y, ballScratch);
+            }
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!balls.asleep[i])
+            {
+                bounceOffWalls(i);
+                advance(i, dt);
+            }
+        }
+    }
+
+    void PhysicsSystem::updateParallel()
+    {
+        const size_t count = balls.size();
+        nextVx.resize(count);
+        nextVy.resize(count);
+        firstImpacts.resize(count);
+
+        // every ball only reads the state from the start of the step and only writes its own
+        // entries, so the result does not depend on how the balls are split between threads.
+        // Only mutual first contacts are solved, a ball whose first impact is with a ball that
+        // hits something else first stops at the contact, and in dense piles the contacts of
+        // one step can still leave small overlaps (around 1e-3 with 2000 balls over 400
+        // steps). Use thread count 0 for the ordered step when that matters
+        jobPool->parallelFor(count, PARALLEL_GRAIN_SIZE, [this](size_t begin, size_t end, unsigned worker)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                findFirstImpact(static_cast<uint32_t>(i), scratch[worker]);
+            }
+        });
+
+        // islands that are about to be hit wake up before anything is solved, their balls
+        // are still at rest so the impacts found against them stay valid
+        for (auto &workerScratch : scratch)
+        {
+            for (auto sleeper : workerScratch.touchedSleepers)
+            {
+                if (balls.asleep[sleeper])
+                {
+                    wakeIsland(sleeper);
+                }
+            }
+            workerScratch.touchedSleepers.clear();
+        }
+        for (auto ball : wokenBalls)
+        {
+            findFirstImpact(ball, scratch[0]);
+        }
+        jobPool->parallelFor(count, PARALLEL_GRAIN_SIZE, [this](size_t begin, size_t end, unsigned worker)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                solveBall(static_cast<uint32_t>(i), scratch[worker]);
+            }
+        });
+
+        balls.vx.swap(nextVx);
+        balls.vy.swap(nextVy);
+    }
+
+    void PhysicsSystem::findFirstImpact(uint32_t ball, Scratch &scratch)
+    {
+        if (balls.asleep[ball])
+        {
+            firstImpacts[ball] = {std::numeric_limits<float>::infinity(), -1, Wall::None};
+            return;
+        }
+        queryCandidates(ball, scratch);
+        for (size_t k = 0; k < scratch.candidates.size(); k++)
+        {
+            gatherCandidate(k, balls.prevX, balls.prevY, scratch);
+        }
+
+        Impact &impact = firstImpacts[ball];
+        size_t k;
+        impact.time = findImpact(startCircle(ball), scratch, impact.wall, k);
+        impact.other = impact.time <= dt && impact.wall == Wall::None ? static_cast<int32_t>(scratch.candidates[k]) : -1;
+        if (impact.other >= 0 && balls.asleep[impact.other])
+        {
+            scratch.touchedSleepers.push_back(impact.other);
+        }
+    }
+
+    void PhysicsSystem::solveBall(uint32_t ball, Scratch &scratch)
+    {
+        if (balls.asleep[ball])
+        {
+            nextVx[ball] = 0.0f;
+            nextVy[ball] = 0.0f;
+            return;
+        }
+        LveNarrowphase::SweptCircle circle = startCircle(ball);
+        const Impact &impact = firstImpacts[ball];
+        float endTime = dt;
+        if (impact.time <= dt)
+        {
+            circle.x += circle.vx * impact.time;
+            circle.y += circle.vy * impact.time;
+            circle.time = impact.time;
+            endTime = impact.time;
+
+            // a contact is only solved when it is the first one for both balls, otherwise
+            // the other ball has already bounced off something else and this one waits at
+            // the contact until the next step
+            if (impact.wall != Wall::None)
+            {
+                wallCollisionSpeed(circle.vx, circle.vy, balls.invMass[ball], impact.wall, circle.vx, circle.vy);
+                endTime = dt;
+            }
+            else if (firstImpacts[impact.other].other == static_cast<int32_t>(ball))
+            {
+                uint32_t other = static_cast<uint32_t>(impact.other);
+                float otherX = balls.prevX[other] + balls.vx[other] * impact.time;
+                float otherY = balls.prevY[other] + balls.vy[other] * impact.time;
+                float otherVx = balls.vx[other], otherVy = balls.vy[other];
+                collisionSpeeds(otherX - circle.x, otherY - circle.y, balls.invMass[ball], balls.invMass[other],
+                    circle.vx, circle.vy, otherVx, otherVy);
+                endTime = dt;
+            }
+
+            // after the bounce the ball stops at whatever it would hit next and that is
+            // solved in the next step. The broadphase only covers broadphaseTravel from the
+            // start and cannot be widened while other threads query it, so a ball that got
+            // faster than that also stops where it would leave it
+            if (endTime > circle.time)
+            {
+                float dx = circle.x - balls.prevX[ball];
+                float dy = circle.y - balls.prevY[ball];
+                float speed = std::sqrt(circle.vx * circle.vx + circle.vy * circle.vy);
+                float left = broadphaseTravel - std::sqrt(dx * dx + dy * dy);
+                if (speed > 0.0f && speed * (endTime - circle.time) > left)
+                {
+                    endTime = circle.time + std::max(left, 0.0f) / speed;
+                }
+                queryCandidates(ball, scratch);
+                for (size_t k = 0; k < scratch.candidates.size(); k++)
+                {
+                    gatherCandidate(k, balls.prevX, balls.prevY, scratch);
+                }
+                Wall wall;
+                size_t k;
+                endTime = std::min(findImpact(circle, scratch, wall, k), endTime);
+            }
+        }
+
+        balls.x[ball] = circle.x + circle.vx * (endTime - circle.time);
+        balls.y[ball] = circle.y + circle.vy * (endTime - circle.time);
+        nextVx[ball] = circle.vx;
+        nextVy[ball] = circle.vy;
+    }
+
+    void PhysicsSystem::bounceOffWalls(uint32_t ball)
+    {
+        for (int impacts = 0; impacts < MAX_IMPACTS_PER_STEP; impacts++)
+        {
+            Wall wall;
+            float time = wallImpactTime(sweptCircle(ball), wall);
+            if (time > dt)
+            {
+                break;
+            }
+            advance(ball, time);
+            wallCollisionSpeed(balls.vx[ball], balls.vy[ball], balls.invMass[ball], wall, balls.vx[ball], balls.vy[ball]);
+        }
+    }
+
+    void PhysicsSystem::advance(uint32_t ball, float time)
+    {
+        balls.x[ball] += balls.vx[ball] * (time - stepTime[ball]);
+        balls.y[ball] += balls.vy[ball] * (time - stepTime[ball]);
+        stepTime[ball] = time;
+    }
+
+    void PhysicsSystem::reportEscaped()
+    {
+        for (uint32_t i = 0; i < balls.size(); i++)
+        {
+            if (balls.x[i] > 1 || balls.x[i] < -1 || balls.y[i] > 1 || balls.y[i] < -1)
+            {
+                if (std::find(escaped.begin(), escaped.end(), i) == escaped.end())
+                {
+                    escaped.push_back(i);
+                    std::cerr << "object [" << i << "] escaped, pos: {"
+                              << balls.x[i] << ", "
+                              << balls.y[i] << "}"
+                              << ", speed : " << balls.getSpeed(i) << ", escaped count: " << escaped.size()
+                              << std::endl;
+                }
+            }
+        }
+    }
+
+    void PhysicsSystem::setSleepEnabled(bool enabled)
+    {
+        sleepEnabled = enabled;
+        if (!enabled)
+        {
+            resetSleep();
+        }
+    }
+
+    void PhysicsSystem::resetSleep()
+    {
+        sleepTime.assign(balls.size(), 0.0f);
+        sleepingIsland.assign(balls.size(), -1);
+        std::fill(balls.asleep.begin(), balls.asleep.end(), 0);
+        islandMembers.clear();
+        freeIslands.clear();
+        sleepingCount = 0;
+    }
+
+    void PhysicsSystem::updateSleep()
+    {
+        if (!sleepEnabled)
+        {
+            return;
+        }
+
+        const uint32_t count = static_cast<uint32_t>(balls.size());
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!balls.asleep[i])
+            {
+                sleepTime[i] = balls.getSpeed(i) < SLEEP_SPEED ? sleepTime[i] + dt : 0.0f;
+            }
+        }
+
+        // sleeping islands stay together, slow balls join whatever they touch. Fast balls are
+        // only joined through the slow ones they touch, which is enough to keep those awake
+        contactIslands.reset(count);
+        for (const auto &members : islandMembers)
+        {
+            for (size_t m = 1; m < members.size(); m++)
+            {
+                contactIslands.unite(members[0], members[m]);
+            }
+        }
+        auto &neighbours = scratch[0].candidates;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (balls.asleep[i] || sleepTime[i] < SLEEP_DELAY)
+            {
+                continue;
+            }
+            neighbours.clear();
+            queryBroadphase(i, neighbours);
+            for (auto j : neighbours)
+            {
+                float dx = balls.x[j] - balls.x[i];
+                float dy = balls.y[j] - balls.y[i];
+                float reach = balls.radius[i] + balls.radius[j] + CONTACT_SLOP;
+                if (j != i && dx * dx + dy * dy <= reach * reach)
+                {
+                    contactIslands.unite(i, j);
+                }
+            }
+        }
+
+        islandMoving.assign(count, 0);
+        islandSlowing.assign(count, 0);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!balls.asleep[i])
+            {
+                uint32_t root = contactIslands.find(i);
+                if (sleepTime[i] < SLEEP_DELAY)
+                {
+                    islandMoving[root] = 1;
+                }
+                else
+                {
+                    islandSlowing[root] = 1;
+                }
+            }
+        }
+
+        // an island with new slow balls and nothing moving falls asleep as a whole, the
+        // sleeping islands it swallowed are merged into it
+        auto fallsAsleep = [this](uint32_t ball)
+        {
+            uint32_t root = contactIslands.find(ball);
+            return islandSlowing[root] && !islandMoving[root];
+        };
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (sleepingIsland[i] >= 0 && fallsAsleep(i) && !islandMembers[sleepingIsland[i]].empty())
+            {
+                sleepingCount -= islandMembers[sleepingIsland[i]].size();
+                islandMembers[sleepingIsland[i]].clear();
+                freeIslands.push_back(sleepingIsland[i]);
+            }
+        }
+
+        islandOfRoot.assign(count, -1);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (!fallsAsleep(i))
+            {
+                continue;
+            }
+            uint32_t root = contactIslands.find(i);
+            if (islandOfRoot[root] < 0)
+            {
+                if (freeIslands.empty())
+                {
+                    islandOfRoot[root] = static_cast<int32_t>(islandMembers.size());
+                    islandMembers.emplace_back();
+                }
+                else
+                {
+                    islandOfRoot[root] = freeIslands.back();
+                    freeIslands.pop_back();
+                }
+            }
+            islandMembers[islandOfRoot[root]].push_back(i);
+            sleepingIsland[i] = islandOfRoot[root];
+            balls.asleep[i] = 1;
+            balls.vx[i] = 0.0f;
+            balls.vy[i] = 0.0f;
+            sleepingCount++;
+        }
+    }
+
+    void PhysicsSystem::wakeIsland(uint32_t ball)
+    {
+        int32_t island = sleepingIsland[ball];
+        for (auto member : islandMembers[island])
+        {
+            balls.asleep[member] = 0;
+            sleepingIsland[member] = -1;
+            sleepTime[member] = 0.0f;
+            wokenBalls.push_back(member);
+        }
+        sleepingCount -= islandMembers[island].size();
+        islandMembers[island].clear();
+        freeIslands.push_back(island);
+    }
+
+    void PhysicsSystem::buildBroadphase()
+    {
+        // a guess at how far a ball gets from its start this step, twice the distance at the
+        // fastest speed. An impact can push a light ball to almost three times the speed of
+        // a heavy one and a ball can be hit several times, so this is no bound: the ordered
+        // step widens it when a ball gets faster and the parallel step stops balls at it
+        widenBroadphase(2.0f * std::max(maxSpeed, 0.0f) * dt);
+
+        if (broadphase == Broadphase::AabbTree)
+        {
+            if (treeProxies.size() != balls.size())
+            {
+                aabbTree.clear();
+                treeProxies.resize(balls.size());
+                for (uint32_t i = 0; i < balls.size(); i++)
+                {
+                    treeProxies[i] = aabbTree.createProxy(ballBox(i, 0.0f), i);
+                }
+            }
+            for (uint32_t i = 0; i < balls.size(); i++)
+            {
+                if (!balls.asleep[i])
+                {
+                    aabbTree.moveProxy(treeProxies[i], ballBox(i, 0.0f), balls.vx[i] * dt, balls.vy[i] * dt);
+                }
+            }
+        }
+    }
+
+    void PhysicsSystem::widenBroadphase(float travel)
+    {
+        broadphaseTravel = travel;
+        if (broadphase == Broadphase::UniformGrid)
+        {
+            float maxRadius = 0.0f;
+            for (auto r : balls.radius)
+            {
+                maxRadius = std::max(maxRadius, r);
+            }
+            grid.build(balls.prevX, balls.prevY, 2.0f * maxRadius + 2.0f * travel);
+        }
+        else if (broadphase == Broadphase::SortAndSweep)
+        {
+            sortAndSweep.update(balls.prevX, balls.prevY, balls.radius, travel);
+        }
+        // the tree's query box is grown by broadphaseTravel, its leaves do not change
+    }
+
+    float PhysicsSystem::reach(uint32_t ball) const
+    {
+        float dx = balls.x[ball] - balls.prevX[ball];
+        float dy = balls.y[ball] - balls.prevY[ball];
+        return std::sqrt(dx * dx + dy * dy) + balls.getSpeed(ball) * (dt - stepTime[ball]);
+    }
+
+    LveAabb PhysicsSystem::ballBox(uint32_t ball, float margin) const
+    {
+        float reach = balls.radius[ball] + margin;
+        return {balls.prevX[ball] - reach, balls.prevY[ball] - reach, balls.prevX[ball] + reach, balls.prevY[ball] + reach};
+    }
+
+    void PhysicsSystem::queryBroadphase(uint32_t ball, std::vector<uint32_t> &out) const{
+        if(broadphase == Broadphase::BruteForce){
+            for(uint32_t j = 0; j < balls.size(); j++){
+                out.push_back(j);
+            }
+        }
+        else if(broadphase == Broadphase::SortAndSweep){
+            sortAndSweep.query(ball, out);
+        }
+        else if(broadphase == Broadphase::AabbTree){
+            // leaves hold the plain ball boxes, so the query box covers both balls' travel
+            const size_t first = out.size();
+            aabbTree.query(ballBox(ball, 2.0f * broadphaseTravel), out);
+            std::sort(out.begin() + first, out.end());
+        }
+        else{
+            grid.query(balls.prevX[ball], balls.prevY[ball], out);
+        }
+    }
+
+    void PhysicsSystem::queryRegion(const LveAabb& region, std::vector<uint32_t>& out) const{
+        const size_t first = out.size();
+        if(broadphase == Broadphase::AabbTree && treeProxies.size() == balls.size()){
+            // the tree saw the balls at the start of the last step, they may have moved since
+            aabbTree.query({region.minX - broadphaseTravel, region.minY - broadphaseTravel,
+                region.maxX + broadphaseTravel, region.maxY + broadphaseTravel}, out);
+        }
+        else{
+            for(uint32_t i = 0; i < balls.size(); i++){
+                out.push_back(i);
+            }
+        }
+
+        // keeps the balls whose circle reaches the closest point of the region
+        auto last = std::remove_if(out.begin() + first, out.end(), [&](uint32_t ball){
+            float dx = balls.x[ball] - std::clamp(balls.x[ball], region.minX, region.maxX);
+            float dy = balls.y[ball] - std::clamp(balls.y[ball], region.minY, region.maxY);
+            return dx * dx + dy * dy > balls.radius[ball] * balls.radius[ball];
+        });
+        out.erase(last, out.end());
+        std::sort(out.begin() + first, out.end());
+    }
+
+    int32_t PhysicsSystem::rayCast(float fromX, float fromY, float toX, float toY) const{
+        std::vector<uint32_t> hits;
+        if(broadphase == Broadphase::AabbTree && treeProxies.size() == balls.size()){
+            aabbTree.rayCast(fromX, fromY, toX, toY, hits, broadphaseTravel);
+        }
+        else{
+            for(uint32_t i = 0; i < balls.size(); i++){
+                hits.push_back(i);
+            }
+        }
+
+        // segment against circle, the smaller root of |from + t * dir - centre| = radius
+        const float dirX = toX - fromX;
+        const float dirY = toY - fromY;
+        const float a = dirX * dirX + dirY * dirY;
+        int32_t closest = -1;
+        float closestT = 1.0f;
+        for(auto ball : hits){
+            float ox = fromX - balls.x[ball];
+            float oy = fromY - balls.y[ball];
+            float c = ox * ox + oy * oy - balls.radius[ball] * balls.radius[ball];
+            float t = 0.0f;
+            if(c > 0.0f){
+                float b = ox * dirX + oy * dirY;
+                float discriminant = b * b - a * c;
+                if(b >= 0.0f || discriminant < 0.0f){
+                    continue;
+                }
+                t = c / (std::sqrt(discriminant) - b);
+            }
+            if(t < closestT || (t == closestT && closest >= 0 && ball < static_cast<uint32_t>(closest))){
+                closestT = t;
+                closest = static_cast<int32_t>(ball);
+            }
+        }
+        return closest;
+    }
+
+    void PhysicsSystem::queryCandidates(uint32_t ball, Scratch &scratch) const{
+        auto &candidates = scratch.candidates;
+        candidates.clear();
+        queryBroadphase(ball, candidates);
+        candidates.erase(std::remove(candidates.begin(), candidates.end(), ball), candidates.end());
+        scratch.candidateCount += candidates.size();
+
+        const size_t count = candidates.size();
+        scratch.x.resize(count);
+        scratch.y.resize(count);
+        scratch.vx.resize(count);
+        scratch.vy.resize(count);
+        scratch.radius.resize(count);
+        scratch.time.resize(count);
+    }
+
+    void PhysicsSystem::gatherCandidate(size_t k, const std::vector<float> &xs, const std::vector<float> &ys, Scratch &scratch) const{
+        uint32_t other = scratch.candidates[k];
+        scratch.x[k] = xs[other];
+        scratch.y[k] = ys[other];
+        scratch.vx[k] = balls.vx[other];
+        scratch.vy[k] = balls.vy[other];
+        scratch.radius[k] = balls.radius[other];
+        scratch.time[k] = stepTime[other];
+    }
+
+    LveNarrowphase::SweptCircle PhysicsSystem::sweptCircle(uint32_t ball) const{
+        return {balls.x[ball], balls.y[ball], balls.vx[ball], balls.vy[ball], balls.radius[ball], stepTime[ball]};
+    }
+
+    LveNarrowphase::SweptCircle PhysicsSystem::startCircle(uint32_t ball) const{
+        return {balls.prevX[ball], balls.prevY[ball], balls.vx[ball], balls.vy[ball], balls.radius[ball], 0.0f};
+    }
+
+    float PhysicsSystem::findImpact(const LveNarrowphase::SweptCircle &circle, const Scratch &scratch, Wall &wall, size_t &candidate) const{
+        float wallTime = wallImpactTime(circle, wall);
+        float ballTime;
+        candidate = narrowphase.findEarliestImpact(circle, scratch.batch(), scratch.candidates.size(), dt, ballTime);
+        if(candidate < scratch.candidates.size() && ballTime < wallTime){
+            wall = Wall::None;
+            return ballTime;
+        }
+        return wallTime;
+    }
+
+    float PhysicsSystem::wallImpactTime(const LveNarrowphase::SweptCircle &circle, Wall &wall) const{
+        // a ball that is already past a wall while moving towards it bounces right away,
+        // that is what used to make fast balls oscillate inside the wall
+        float earliest = std::numeric_limits<float>::infinity();
+        wall = Wall::None;
+        auto check = [&](float position, float speed, float limit, Wall candidateWall){
+            float time = circle.time + (limit - position) / speed;
+            time = std::max(time, circle.time);
+            if(time <= dt && time < earliest){
+                earliest = time;
+                wall = candidateWall;
+            }
+        };
+
+        float reach = 1.0f - circle.radius;
+        if(circle.vx > 0.0f){
+            check(circle.x, circle.vx, reach, Wall::Right);
+        }
+        else if(circle.vx < 0.0f){
+            check(circle.x, circle.vx, -reach, Wall::Left);
+        }
+        if(circle.vy > 0.0f){
+            check(circle.y, circle.vy, reach, Wall::Upper);
+        }
+        else if(circle.vy < 0.0f){
+            check(circle.y, circle.vy, -reach, Wall::Bottom);
+        }
+        return earliest;
+    }
+
+    void PhysicsSystem::wallCollisionSpeed(float vx, float vy, float invMass, Wall wall, float &outVx, float &outVy) const{
+        // outward normal of the wall that was hit
+        float normalX = 0.0f, normalY = 0.0f;
+        switch(wall){
+            case Wall::Right: normalX = 1.0f; break;
+            case Wall::Left: normalX = -1.0f; break;
+            case Wall::Upper: normalY = 1.0f; break;
+            case Wall::Bottom: normalY = -1.0f; break;
+            default:
+                throw std::runtime_error("That wall doesn't exist : " + std::to_string(static_cast<int>(wall)));
+        }
+
+        outVx = vx;
+        outVy = vy;
+        float approach = vx * normalX + vy * normalY;
+        if(approach <= 0.0f){
+            // already moving away, bouncing again would push it back into the wall
+            return;
+        }
+
+        // the wall is a very heavy ball, as in the old angle based formula
+        float impulse = (1.0f + restitution) * approach / (invMass + 1.0f / WALL_MASS);
+        outVx -= impulse * invMass * normalX;
+        outVy -= impulse * invMass * normalY;
+    }
+
+    void PhysicsSystem::collisionSpeeds(float normalX, float normalY, float invMass1, float invMass2,
+        float &vx1, float &vy1, float &vx2, float &vy2) const{
+        // contact normal along the line between the centres, from the first ball to the second
+        float distanceSquared = normalX * normalX + normalY * normalY;
+        if(distanceSquared == 0.0f){
+            return;
+        }
+        float invDistance = 1.0f / sqrt(distanceSquared);
+        normalX *= invDistance;
+        normalY *= invDistance;
+
+        // relative speed along the normal, positive while the balls approach each other
+        float approach = (vx1 - vx2) * normalX + (vy1 - vy2) * normalY;
+        if(approach <= 0.0f){
+            return;
+        }
+
+        float impulse = (1.0f + restitution) * approach / (invMass1 + invMass2);
+
+        vx1 -= impulse * invMass1 * normalX;
+        vy1 -= impulse * invMass1 * normalY;
+        vx2 += impulse * invMass2 * normalX;
+        vy2 += impulse * invMass2 * normalY;
+    }
+
+    glm::vec3 PhysicsSystem::getColorFromSpeed(uint32_t ball) const{
+        glm::vec3 result;
+        float speed = balls.getSpeed(ball);
+
+        if(maxSpeed - speed < speed - minSpeed){
+            result.r = (speed / maxSpeed);
+            result.b = 0.1f;
+        }
+        else{
+            result.r = 0.1f;
+            result.b = (speed / minSpeed);
+        }
+
+        return result;
+    }
+
+    void PhysicsSystem::calcMinMaxSpeed(){
+        minSpeed = 100.f;
+        maxSpeed = -1.0f;
+        for(uint32_t i = 0; i < balls.size(); i++){
+            if(balls.asleep[i]){
+                continue;
+            }
+            float speed = balls.getSpeed(i);
+            if(speed > maxSpeed){
+                maxSpeed = speed;
+            }
+            if(speed < minSpeed){
+                minSpeed = speed;
+            }
+        }
+    }
+
+}
@@ -1,30 +1,170 @@
-// #include "lve_game_object.hpp"
 #pragma once
+#include "lve_ball_store.hpp"
+#include "lve_uniform_grid.hpp"
+#include "lve_sort_and_sweep.hpp"
+#include "lve_aabb_tree.hpp"
+#include "lve_narrowphase.hpp"
+#include "lve_job_pool.hpp"
+#include "lve_contact_islands.hpp"
 
-// namespace lve{
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
 
-//     class PhysicsSystem{
-//         public:
-//             PhysicsSystem(std::vector<LveGameObject>& gameObjects);
+#include <cstdint>
+#include <memory>
+#include <vector>
 
-//             void update();
-//             void calcMinMaxSpeed();
+namespace lve{
 
+    class PhysicsSystem{
+        public:
+            // BruteForce tests every ball against every other ball and is kept as the
+            // reference path; UniformGrid only sends balls from neighbouring cells,
+            // SortAndSweep and AabbTree balls whose boxes overlap to the narrowphase. All of
+            // them visit the candidates in the same order, so they give the same result
+            enum class Broadphase{ BruteForce, UniformGrid, SortAndSweep, AabbTree };
 
-//         private:
-//             std::vector<LveGameObject>& gameObjects;
-//             float minSpeed{10.0}, maxSpeed{-1.0};
+            PhysicsSystem(LveBallStore& balls, Broadphase broadphase = Broadphase::UniformGrid);
 
+            // balls handed to one job of the parallel step
+            static constexpr size_t PARALLEL_GRAIN_SIZE = 256;
+            // walls respond like a ball of this mass
+            static constexpr float WALL_MASS = 10000.0f;
+            // in the ordered step a ball stops looking for further impacts after this many
+            // and just moves for the rest of the step
+            static constexpr int MAX_IMPACTS_PER_STEP = 4;
+            // a ball that stays slower than SLEEP_SPEED for SLEEP_DELAY seconds falls asleep
+            // together with every ball it touches, once all of those are slow as well
+            static constexpr float SLEEP_SPEED = 0.01f;
+            static constexpr float SLEEP_DELAY = 0.5f;
+            // gap up to which two balls still count as touching when islands are built
+            static constexpr float CONTACT_SLOP = 0.002f;
 
-//           //  void adjustForWall(LveGameObject &obj);
-//             bool checkIfCollidedWithWall(LveGameObject& object1);
-//             bool checkIfCollidedAndUpdate(LveGameObject &object1, LveGameObject &object2);
-//             void updateVecSpeed(LveGameObject &object1, LveGameObject &object2);
-//             void updateSpeedForWallCollision(LveGameObject& obj, std::string wall);
-//             void checkQuadrant(float x, float y, float& angle);
-//             glm::vec3 getColorFromSpeed(LveGameObject& obj);
-//     };
+            // advances the simulation by dt seconds, speeds are in arena units per second.
+            // Contacts are found with swept circles, so a ball moves to its earliest impact
+            // within the step, bounces and carries on, and fast balls do not tunnel
+            void update(float dt);
+            // candidates the broadphase handed to the narrowphase during the last update
+            size_t getLastCandidateCount() const{return lastCandidateCount;}
+            void calcMinMaxSpeed();
+            glm::vec3 getColorFromSpeed(uint32_t ball) const;
 
+            void setBroadphase(Broadphase newBroadphase){broadphase = newBroadphase;}
+            Broadphase getBroadphase() const{return broadphase;}
+            void setNarrowphaseKernel(LveNarrowphase::Kernel kernel){narrowphase.setKernel(kernel);}
+            LveNarrowphase::Kernel getNarrowphaseKernel() const{return narrowphase.getKernel();}
 
+            // 0 keeps the ordered single-threaded step. Any other count runs the parallel
+            // step, where every ball is swept against the others' paths from the start of the
+            // step and only solves its first impact; its result is the same for every thread
+            // count but not the same as the ordered step. Only contacts that are the first
+            // impact of both balls are solved, the rest wait at the contact for the next step,
+            // so dense piles can keep small overlaps the ordered step would have resolved
+            void setThreadCount(unsigned threadCount);
+            unsigned getThreadCount() const{return jobPool ? jobPool->getThreadCount() : 0;}
 
-// }
\ No newline at end of file
+            // 1 keeps collisions perfectly elastic, 0 removes all speed along the contact normal
+            void setRestitution(float newRestitution){restitution = newRestitution;}
+            float getRestitution() const{return restitution;}
+
+            // balls whose circles overlap the region and the first ball the segment from
+            // (fromX, fromY) to (toX, toY) hits, -1 if none. Both use the AABB tree while it
+            // is the broadphase and test every ball otherwise
+            void queryRegion(const LveAabb& region, std::vector<uint32_t>& out) const;
+            int32_t rayCast(float fromX, float fromY, float toX, float toY) const;
+
+            // sleeping balls are neither moved nor swept against the others until a moving
+            // ball hits one of them, which wakes its whole island
+            void setSleepEnabled(bool enabled);
+            bool isSleepEnabled() const{return sleepEnabled;}
+            size_t getSleepingCount() const{return sleepingCount;}
+
+
+        private:
+            LveBallStore& balls;
+            float minSpeed{10.0}, maxSpeed{-1.0};
+            float restitution{1.0f};
+
+            Broadphase broadphase;
+            LveUniformGrid grid;
+            LveSortAndSweep sortAndSweep;
+            // leaves are already stretched along each ball's motion, the margin only covers
+            // balls that barely move
+            LveAabbTree aabbTree{0.001f};
+            std::vector<int32_t> treeProxies;
+            // distance a ball can be from where the broadphase saw it
+            float broadphaseTravel{0.0f};
+            float dt{0.0f};
+            size_t lastCandidateCount{0};
+            LveNarrowphase narrowphase;
+
+            // per thread candidate list and the candidates' paths for the narrowphase
+            struct Scratch{
+                std::vector<uint32_t> candidates;
+                std::vector<float> x, y, vx, vy, radius, time;
+                size_t candidateCount{0};
+                // sleeping balls that were the first impact of a ball in the parallel step
+                std::vector<uint32_t> touchedSleepers;
+                LveNarrowphase::SweptBatch batch() const{
+                    return {x.data(), y.data(), vx.data(), vy.data(), radius.data(), time.data()};
+                }
+            };
+            std::unique_ptr<LveJobPool> jobPool;
+            std::vector<Scratch> scratch;
+            // time within the step each ball's position in balls.x, balls.y belongs to
+            std::vector<float> stepTime;
+            std::vector<float> nextVx, nextVy;
+            // earliest impact of every ball in the parallel step, other is -1 for walls and no impact
+            struct Impact{
+                float time;
+                int32_t other;
+                LveBallStore::Wall wall;
+            };
+            std::vector<Impact> firstImpacts;
+            std::vector<uint32_t> escaped;
+
+            bool sleepEnabled{true};
+            size_t sleepingCount{0};
+            // how long every ball has been slower than SLEEP_SPEED
+            std::vector<float> sleepTime;
+            // island every sleeping ball belongs to, -1 while it is awake
+            std::vector<int32_t> sleepingIsland;
+            std::vector<std::vector<uint32_t>> islandMembers;
+            std::vector<int32_t> freeIslands;
+            LveContactIslands contactIslands;
+            std::vector<uint8_t> islandMoving, islandSlowing;
+            std::vector<int32_t> islandOfRoot;
+            std::vector<uint32_t> wokenBalls;
+
+
+            void updateSequential();
+            void updateParallel();
+            void findFirstImpact(uint32_t ball, Scratch &scratch);
+            void solveBall(uint32_t ball, Scratch &scratch);
+            void bounceOffWalls(uint32_t ball);
+            void advance(uint32_t ball, float time);
+            void reportEscaped();
+            void resetSleep();
+            void updateSleep();
+            void wakeIsland(uint32_t ball);
+            void buildBroadphase();
+            // rebuilds the broadphase over the start positions to cover travel
+            void widenBroadphase(float travel);
+            // distance from its start the ball can be at the end of the step if it hits nothing more
+            float reach(uint32_t ball) const;
+            void queryBroadphase(uint32_t ball, std::vector<uint32_t> &out) const;
+            LveAabb ballBox(uint32_t ball, float margin) const;
+            void queryCandidates(uint32_t ball, Scratch &scratch) const;
+            void gatherCandidate(size_t k, const std::vector<float> &xs, const std::vector<float> &ys, Scratch &scratch) const;
+            LveNarrowphase::SweptCircle sweptCircle(uint32_t ball) const;
+            LveNarrowphase::SweptCircle startCircle(uint32_t ball) const;
+            float findImpact(const LveNarrowphase::SweptCircle &circle, const Scratch &scratch, LveBallStore::Wall &wall, size_t &candidate) const;
+            float wallImpactTime(const LveNarrowphase::SweptCircle &circle, LveBallStore::Wall &wall) const;
+            void collisionSpeeds(float normalX, float normalY, float invMass1, float invMass2, float &vx1, float &vy1, float &vx2, float &vy2) const;
+            void wallCollisionSpeed(float vx, float vy, float invMass, LveBallStore::Wall wall, float &outVx, float &outVy) const;
+    };
+
+
+
+}
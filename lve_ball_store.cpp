@@ -0,0 +1,39 @@
+#include "lve_ball_store.hpp"
+
+#include <cassert>
+#include <cmath>
+
+namespace lve{
+
+    uint32_t LveBallStore::add(float posX, float posY, float speedX, float speedY, float ballRadius, float mass){
+        assert(mass > 0.0f && "Ball mass must be positive");
+        uint32_t index = static_cast<uint32_t>(x.size());
+        x.push_back(posX);
+        y.push_back(posY);
+        prevX.push_back(posX);
+        prevY.push_back(posY);
+        vx.push_back(speedX);
+        vy.push_back(speedY);
+        radius.push_back(ballRadius);
+        invMass.push_back(1.0f / mass);
+        asleep.push_back(0);
+        return index;
+    }
+
+    void LveBallStore::clear(){
+        x.clear();
+        y.clear();
+        prevX.clear();
+        prevY.clear();
+        vx.clear();
+        vy.clear();
+        radius.clear();
+        invMass.clear();
+        asleep.clear();
+    }
+
+    float LveBallStore::getSpeed(uint32_t i) const{
+        return std::sqrt(vx[i] * vx[i] + vy[i] * vy[i]);
+    }
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve{
+
+    // State of every simulated ball as a structure of arrays, so the collision loop only
+    // streams the fields it touches. Game objects refer into it with LveGameObject::ballIndex.
+    class LveBallStore{
+        public:
+        enum class Wall : uint8_t{ None, Right, Left, Upper, Bottom };
+
+        uint32_t add(float posX, float posY, float speedX, float speedY, float ballRadius, float mass);
+        void clear();
+
+        size_t size() const{return x.size();}
+        bool empty() const{return x.empty();}
+        float getSpeed(uint32_t i) const;
+        float getMass(uint32_t i) const{return 1.0f / invMass[i];}
+
+        std::vector<float> x, y;
+        // positions at the start of the last physics step, rendering interpolates from them
+        std::vector<float> prevX, prevY;
+        std::vector<float> vx, vy;
+        std::vector<float> radius;
+        std::vector<float> invMass;
+        // 1 while the physics has put the ball to sleep, it then has no speed and does not move
+        std::vector<uint8_t> asleep;
+    };
+}
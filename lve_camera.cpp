@@ -26,4 +26,32 @@ void LveCamera::setPerspectiveProjection(float fovy, float aspect, float near, f
   projectionMatrix[3][2] = -(far * near) / (far - near);
 }
 
+std::array<glm::vec4, 6> LveCamera::getFrustumPlanes() const {
+  // clip space keeps -w <= x, y <= w and 0 <= z <= w, every bound is a sum of matrix rows
+  const glm::mat4 projectionView = getProjectionView();
+  auto row = [&](int i) {
+    return glm::vec4{projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]};
+  };
+  std::array<glm::vec4, 6> planes{
+      row(3) + row(0),
+      row(3) - row(0),
+      row(3) + row(1),
+      row(3) - row(1),
+      row(2),
+      row(3) - row(2)};
+  for (auto &plane : planes) {
+    plane /= glm::length(glm::vec3{plane});
+  }
+  return planes;
+}
+
+bool LveCamera::isSphereVisible(const std::array<glm::vec4, 6> &planes, glm::vec3 center, float radius) {
+  for (auto &plane : planes) {
+    if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <array>
 
 namespace lve{
     class LveCamera{
@@ -14,8 +15,18 @@ namespace lve{
         void setPerspectiveProjection(float fovy, float aspect, float near, float far);
 
         const glm::mat4& getProjection()const{return projectionMatrix;}
+        // world to camera space, identity until it is set
+        void setViewMatrix(const glm::mat4 &view){viewMatrix = view;}
+        const glm::mat4& getView()const{return viewMatrix;}
+        glm::mat4 getProjectionView()const{return projectionMatrix * viewMatrix;}
+        // left, right, bottom, top, near and far planes of projection * view in world space with
+        // normals pointing inwards, a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+        std::array<glm::vec4, 6> getFrustumPlanes() const;
+        // false only when the sphere lies completely outside one of the planes
+        static bool isSphereVisible(const std::array<glm::vec4, 6> &planes, glm::vec3 center, float radius);
     private:
         glm::mat4 projectionMatrix{1.f};
+        glm::mat4 viewMatrix{1.f};
 
     };
 
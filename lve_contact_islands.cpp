@@ -0,0 +1,38 @@
+#include "lve_contact_islands.hpp"
+
+#include <utility>
+
+namespace lve{
+
+    void LveContactIslands::reset(size_t count){
+        parent.resize(count);
+        size.assign(count, 1);
+        for(size_t i = 0; i < count; i++){
+            parent[i] = static_cast<uint32_t>(i);
+        }
+    }
+
+    void LveContactIslands::unite(uint32_t a, uint32_t b){
+        a = find(a);
+        b = find(b);
+        if(a == b){
+            return;
+        }
+        // the smaller island goes under the larger one so the trees stay shallow
+        if(size[a] < size[b]){
+            std::swap(a, b);
+        }
+        parent[b] = a;
+        size[a] += size[b];
+    }
+
+    uint32_t LveContactIslands::find(uint32_t ball){
+        while(parent[ball] != ball){
+            // path halving
+            parent[ball] = parent[parent[ball]];
+            ball = parent[ball];
+        }
+        return ball;
+    }
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve{
+
+    // Union-find over the balls, joined by the contacts between them. Every group of
+    // balls that touch each other directly or through others ends up with the same root.
+    class LveContactIslands{
+        public:
+
+        // puts every ball into an island of its own
+        void reset(size_t count);
+        void unite(uint32_t a, uint32_t b);
+        uint32_t find(uint32_t ball);
+
+        private:
+            std::vector<uint32_t> parent;
+            std::vector<uint32_t> size;
+    };
+}
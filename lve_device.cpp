@@ -53,11 +53,15 @@ LveDevice::LveDevice(LveWindow &window) : window{window} {
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
+  allocator = std::make_unique<LveAllocator>(physicalDevice, device_);
+  pipelineCache = std::make_unique<LvePipelineCache>(device_, properties, PIPELINE_CACHE_PATH);
   createCommandPool();
 }
 
 LveDevice::~LveDevice() {
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  allocator.reset();
+  pipelineCache.reset();
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
@@ -130,7 +134,26 @@ void LveDevice::pickPhysicalDevice() {
   }
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
   std::cout << "physical device: " << properties.deviceName << std::endl;
+
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      physicalDevice,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+  enabledDeviceExtensions = deviceExtensions;
+  for (const char *optional : optionalDeviceExtensions) {
+    for (const auto &extension : availableExtensions) {
+      if (strcmp(optional, extension.extensionName) == 0) {
+        enabledDeviceExtensions.push_back(optional);
+        break;
+      }
+    }
+  }
 }
 
 void LveDevice::createLogicalDevice() {
@@ -151,6 +174,8 @@ void LveDevice::createLogicalDevice() {
 
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // lets one indirect call draw several commands
+  deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -159,8 +184,8 @@ void LveDevice::createLogicalDevice() {
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -177,6 +202,73 @@ void LveDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+  for (const char *extension : enabledDeviceExtensions) {
+    if (strcmp(extension, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0) {
+      drawIndirectCount = (PFN_vkCmdDrawIndirectCountKHR)vkGetDeviceProcAddr(
+          device_,
+          "vkCmdDrawIndirectCountKHR");
+      drawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(
+          device_,
+          "vkCmdDrawIndexedIndirectCountKHR");
+    }
+  }
+}
+
+void LveDevice::cmdDrawIndirectCount(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) {
+  if (drawIndirectCount != nullptr) {
+    drawIndirectCount(
+        commandBuffer,
+        buffer,
+        offset,
+        countBuffer,
+        countBufferOffset,
+        maxDrawCount,
+        stride);
+    return;
+  }
+  if (maxDrawCount > 1 && !supportedFeatures.multiDrawIndirect) {
+    for (uint32_t i = 0; i < maxDrawCount; i++) {
+      vkCmdDrawIndirect(commandBuffer, buffer, offset + i * stride, 1, stride);
+    }
+    return;
+  }
+  vkCmdDrawIndirect(commandBuffer, buffer, offset, maxDrawCount, stride);
+}
+
+void LveDevice::cmdDrawIndexedIndirectCount(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) {
+  if (drawIndexedIndirectCount != nullptr) {
+    drawIndexedIndirectCount(
+        commandBuffer,
+        buffer,
+        offset,
+        countBuffer,
+        countBufferOffset,
+        maxDrawCount,
+        stride);
+    return;
+  }
+  if (maxDrawCount > 1 && !supportedFeatures.multiDrawIndirect) {
+    for (uint32_t i = 0; i < maxDrawCount; i++) {
+      vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset + i * stride, 1, stride);
+    }
+    return;
+  }
+  vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, maxDrawCount, stride);
 }
 
 void LveDevice::createCommandPool() {
@@ -328,7 +420,9 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
 
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+    // the culling compute pass is recorded into the graphics command buffers
+    if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+        (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
@@ -408,7 +502,7 @@ void LveDevice::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    LveAllocation &bufferMemory) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -422,16 +516,18 @@ void LveDevice::createBuffer(
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  bufferMemory = allocator->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      true);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
-  }
+  vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
+}
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+void LveDevice::destroyBuffer(VkBuffer &buffer, LveAllocation &bufferMemory) {
+  vkDestroyBuffer(device_, buffer, nullptr);
+  buffer = VK_NULL_HANDLE;
+  allocator->free(bufferMemory);
 }
 
 VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -467,7 +563,8 @@ void LveDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
 }
 
 void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+  bool batched = uploadCommandBuffer != VK_NULL_HANDLE;
+  VkCommandBuffer commandBuffer = batched ? uploadCommandBuffer : beginSingleTimeCommands();
 
   VkBufferCopy copyRegion{};
   copyRegion.srcOffset = 0;  // Optional
@@ -475,7 +572,51 @@ void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
+  if (!batched) {
+    endSingleTimeCommands(commandBuffer);
+  }
+}
+
+void LveDevice::uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer) {
+  StagingBuffer staging;
+  createBuffer(
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      staging.buffer,
+      staging.memory);
+
+  memcpy(staging.memory.mapped, data, static_cast<size_t>(size));
+
+  copyBuffer(staging.buffer, dstBuffer, size);
+
+  if (uploadCommandBuffer != VK_NULL_HANDLE) {
+    pendingStagingBuffers.push_back(staging);
+    return;
+  }
+  // the unbatched copy already waited for the queue
+  destroyBuffer(staging.buffer, staging.memory);
+}
+
+void LveDevice::beginUploadBatch() {
+  if (uploadCommandBuffer != VK_NULL_HANDLE) {
+    throw std::runtime_error("upload batch already begun!");
+  }
+  uploadCommandBuffer = beginSingleTimeCommands();
+}
+
+void LveDevice::endUploadBatch() {
+  if (uploadCommandBuffer == VK_NULL_HANDLE) {
+    throw std::runtime_error("no upload batch to end!");
+  }
+  VkCommandBuffer commandBuffer = uploadCommandBuffer;
+  uploadCommandBuffer = VK_NULL_HANDLE;
   endSingleTimeCommands(commandBuffer);
+
+  for (auto &staging : pendingStagingBuffers) {
+    destroyBuffer(staging.buffer, staging.memory);
+  }
+  pendingStagingBuffers.clear();
 }
 
 void LveDevice::copyBufferToImage(
@@ -509,7 +650,7 @@ void LveDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    LveAllocation &imageMemory) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,18 +658,20 @@ void LveDevice::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
+  imageMemory = allocator->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+  if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
 }
 
+void LveDevice::destroyImage(VkImage &image, LveAllocation &imageMemory) {
+  vkDestroyImage(device_, image, nullptr);
+  image = VK_NULL_HANDLE;
+  allocator->free(imageMemory);
+}
+
 }  // namespace lve
\ No newline at end of file
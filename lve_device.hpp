@@ -1,8 +1,11 @@
 #pragma once
 
 #include "lve_window.hpp"
+#include "lve_allocator.hpp"
+#include "lve_pipeline_cache.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -52,15 +55,26 @@ class LveDevice {
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // buffers and images get their memory from the device's LveAllocator, host visible
+  // memory comes already mapped through LveAllocation::mapped
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveAllocation &bufferMemory);
+  void destroyBuffer(VkBuffer &buffer, LveAllocation &bufferMemory);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  // copies size bytes of data into dstBuffer through a host visible staging buffer, for
+  // device local buffers the host cannot map. dstBuffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+  void uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer);
+  // copies between beginUploadBatch and endUploadBatch are recorded into one command buffer
+  // and submitted together by endUploadBatch, which also frees their staging buffers.
+  // The destination buffers must not be used before that
+  void beginUploadBatch();
+  void endUploadBatch();
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -68,7 +82,33 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveAllocation &imageMemory);
+  void destroyImage(VkImage &image, LveAllocation &imageMemory);
+  LveAllocator::Stats getMemoryStats() const { return allocator->getStats(); }
+  // loaded from PIPELINE_CACHE_PATH at startup and written back when the device is destroyed
+  VkPipelineCache getPipelineCache() const { return pipelineCache->getCache(); }
+
+  // records vkCmdDrawIndirectCountKHR when the device has VK_KHR_draw_indirect_count,
+  // otherwise a plain indirect draw of maxDrawCount commands. Unused commands must then
+  // have an instanceCount of 0
+  void cmdDrawIndirectCount(
+      VkCommandBuffer commandBuffer,
+      VkBuffer buffer,
+      VkDeviceSize offset,
+      VkBuffer countBuffer,
+      VkDeviceSize countBufferOffset,
+      uint32_t maxDrawCount,
+      uint32_t stride);
+  // same for indexed draws with VkDrawIndexedIndirectCommand
+  void cmdDrawIndexedIndirectCount(
+      VkCommandBuffer commandBuffer,
+      VkBuffer buffer,
+      VkDeviceSize offset,
+      VkBuffer countBuffer,
+      VkDeviceSize countBufferOffset,
+      uint32_t maxDrawCount,
+      uint32_t stride);
+  bool hasDrawIndirectCount() const { return drawIndirectCount != nullptr; }
 
   VkPhysicalDeviceProperties properties;
 
@@ -103,9 +143,26 @@ class LveDevice {
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  std::unique_ptr<LveAllocator> allocator;
+  std::unique_ptr<LvePipelineCache> pipelineCache;
+  static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  // enabled when the device has them
+  const std::vector<const char *> optionalDeviceExtensions = {VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME};
+  std::vector<const char *> enabledDeviceExtensions;
+  VkPhysicalDeviceFeatures supportedFeatures{};
+  PFN_vkCmdDrawIndirectCountKHR drawIndirectCount = nullptr;
+  PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+
+  // open upload batch, VK_NULL_HANDLE outside of one
+  VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+  struct StagingBuffer {
+    VkBuffer buffer;
+    LveAllocation memory;
+  };
+  std::vector<StagingBuffer> pendingStagingBuffers;
 };
 
 }  // namespace lve
\ No newline at end of file
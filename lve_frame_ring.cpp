@@ -0,0 +1,189 @@
+#include "lve_frame_ring.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace lve{
+
+    LveFrameRing::LveFrameRing(LveDevice &device, VkDeviceSize regionSize, VkDeviceSize uniformRange, VkDeviceSize storageRange) : lveDevice{device}{
+        const VkPhysicalDeviceLimits& limits = lveDevice.properties.limits;
+        alignment = std::max<VkDeviceSize>({limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 16});
+        this->uniformRange = std::min<VkDeviceSize>(uniformRange, limits.maxUniformBufferRange);
+        this->storageRange = std::min<VkDeviceSize>(storageRange, limits.maxStorageBufferRange);
+        // dynamic offsets are 32 bit, the descriptor ranges also need room past the last piece
+        maxRegionSize = (std::numeric_limits<uint32_t>::max() - std::max(this->uniformRange, this->storageRange)) / alignment * alignment;
+
+        frames.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        createDescriptorSets();
+        for(auto& frame : frames){
+            createRegion(frame, regionSize);
+        }
+    }
+
+    LveFrameRing::~LveFrameRing(){
+        vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+        for(auto& frame : frames){
+            destroyBuffer(frame.region);
+            for(auto& overflow : frame.overflowBuffers){
+                destroyBuffer(overflow);
+            }
+        }
+    }
+
+    LveFrameRing::Buffer LveFrameRing::createBuffer(VkDeviceSize size){
+        Buffer buffer{};
+        lveDevice.createBuffer(
+            size,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer.buffer,
+            buffer.memory);
+        return buffer;
+    }
+
+    void LveFrameRing::destroyBuffer(Buffer &buffer){
+        if(buffer.buffer != VK_NULL_HANDLE){
+            lveDevice.destroyBuffer(buffer.buffer, buffer.memory);
+            buffer.buffer = VK_NULL_HANDLE;
+        }
+    }
+
+    void LveFrameRing::createRegion(Frame &frame, VkDeviceSize regionSize){
+        regionSize = std::min((regionSize + alignment - 1) / alignment * alignment, maxRegionSize);
+        destroyBuffer(frame.region);
+        // the tail keeps the descriptor ranges inside the buffer for pieces at the very end
+        frame.region = createBuffer(regionSize + std::max(uniformRange, storageRange));
+        frame.regionSize = regionSize;
+
+        // both windows start at 0, the dynamic offsets move them onto the pieces
+        std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+        bufferInfos[0] = {frame.region.buffer, 0, uniformRange};
+        bufferInfos[1] = {frame.region.buffer, 0, storageRange};
+        std::array<VkDescriptorType, 2> types = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC};
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        for(uint32_t i = 0; i < writes.size(); i++){
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = types[i];
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(lveDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    void LveFrameRing::createDescriptorSets(){
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if(vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create frame ring descriptor set layout!");
+        }
+
+        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        poolSizes[0].descriptorCount = static_cast<uint32_t>(frames.size());
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        poolSizes[1].descriptorCount = static_cast<uint32_t>(frames.size());
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = static_cast<uint32_t>(frames.size());
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        if(vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create frame ring descriptor pool!");
+        }
+
+        std::vector<VkDescriptorSetLayout> layouts(frames.size(), descriptorSetLayout);
+        std::vector<VkDescriptorSet> descriptorSets(frames.size());
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+        allocInfo.pSetLayouts = layouts.data();
+        if(vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate frame ring descriptor sets!");
+        }
+        for(size_t i = 0; i < frames.size(); i++){
+            frames[i].descriptorSet = descriptorSets[i];
+        }
+    }
+
+    void LveFrameRing::beginFrame(int frameIndex){
+        this->frameIndex = frameIndex;
+        Frame &frame = frames[frameIndex];
+        // the frame's commands have finished, so its buffers are free to go
+        for(auto& overflow : frame.overflowBuffers){
+            destroyBuffer(overflow);
+        }
+        frame.overflowBuffers.clear();
+        VkDeviceSize needed = frame.requested + std::min(DESCRIPTOR_RESERVE, frame.regionSize / 2);
+        if(needed > frame.regionSize && frame.regionSize < maxRegionSize){
+            // some headroom so a slowly growing scene does not grow it every frame
+            createRegion(frame, needed + needed / 2);
+        }
+        frame.requested = 0;
+        head = 0;
+    }
+
+    bool LveFrameRing::allocateInRegion(VkDeviceSize size, VkDeviceSize limit, VkDeviceSize &offset){
+        Frame &frame = frames[frameIndex];
+        VkDeviceSize alignedSize = (size + alignment - 1) / alignment * alignment;
+        frame.requested += alignedSize;
+        offset = (head + alignment - 1) / alignment * alignment;
+        if(offset + size > limit){
+            return false;
+        }
+        head = offset + size;
+        return true;
+    }
+
+    LveFrameRing::Allocation LveFrameRing::allocate(VkDeviceSize size){
+        Frame &frame = frames[frameIndex];
+        VkDeviceSize offset;
+        if(!allocateInRegion(size, frame.regionSize, offset)){
+            // a piece outside the region would be bound through the descriptor set at an
+            // offset into the wrong buffer
+            throw std::runtime_error("frame ring region has no room left for descriptor data!");
+        }
+        return {static_cast<char*>(frame.region.memory.mapped) + offset, static_cast<uint32_t>(offset), frame.region.buffer};
+    }
+
+    LveFrameRing::Allocation LveFrameRing::allocateVertices(VkDeviceSize size){
+        Frame &frame = frames[frameIndex];
+        VkDeviceSize reserve = std::min(DESCRIPTOR_RESERVE, frame.regionSize / 2);
+        VkDeviceSize offset;
+        if(allocateInRegion(size, frame.regionSize - reserve, offset)){
+            return {static_cast<char*>(frame.region.memory.mapped) + offset, static_cast<uint32_t>(offset), frame.region.buffer};
+        }
+        frame.overflowBuffers.push_back(createBuffer(std::max(size, alignment)));
+        Buffer &overflow = frame.overflowBuffers.back();
+        return {overflow.memory.mapped, 0, overflow.buffer};
+    }
+
+    void LveFrameRing::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t uniformOffset, uint32_t storageOffset) const{
+        const Frame &frame = frames[frameIndex];
+        // only allocate() hands out pieces the descriptor set covers
+        if(uniformOffset >= frame.regionSize || storageOffset >= frame.regionSize){
+            throw std::runtime_error("frame ring offset is outside the region bound by the descriptor set!");
+        }
+        uint32_t dynamicOffsets[] = {uniformOffset, storageOffset};
+        vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, set, 1, &frame.descriptorSet, 2, dynamicOffsets);
+    }
+}
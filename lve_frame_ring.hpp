@@ -0,0 +1,107 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace lve{
+
+    // A persistently mapped host visible region per frame in flight. Every frame hands out
+    // aligned pieces of its region for data that only lives for that frame, like camera and
+    // instance data, and starts over at the front of the region the next time the frame comes
+    // round. Each region has a descriptor set with a dynamic uniform buffer at binding 0 and a
+    // dynamic storage buffer at binding 1 over the whole region, so a piece is bound by passing
+    // its offset as the dynamic offset. The region can also be bound as a vertex buffer at a
+    // piece's offset.
+    // Vertex data that does not fit the region gets a buffer of its own for the rest of the
+    // frame, and the region grows to what the frame asked for the next time the frame begins.
+    // Vertex data never takes the last DESCRIPTOR_RESERVE bytes of a region, they are kept for
+    // the uniform and storage data that has to be bound through the descriptor set.
+    class LveFrameRing{
+        public:
+        static constexpr VkDeviceSize DEFAULT_REGION_SIZE = VkDeviceSize{4} << 20;
+        static constexpr VkDeviceSize DESCRIPTOR_RESERVE = VkDeviceSize{64} << 10;
+
+        struct Allocation{
+            void *mapped;
+            // from the start of buffer, also the dynamic offset to bind it with
+            uint32_t offset;
+            // getBuffer(), or for allocateVertices a buffer of its own when the region was full
+            VkBuffer buffer;
+        };
+
+        // uniformRange and storageRange are how many bytes binding 0 and 1 see from their
+        // dynamic offset, clamped to the device's limits
+        LveFrameRing(LveDevice &device, VkDeviceSize regionSize = DEFAULT_REGION_SIZE, VkDeviceSize uniformRange = 256, VkDeviceSize storageRange = VkDeviceSize{64} << 10);
+        ~LveFrameRing();
+
+        LveFrameRing(const LveFrameRing&) = delete;
+        LveFrameRing &operator=(const LveFrameRing &) = delete;
+
+        // starts handing out the frame's region from the front. The frame's earlier commands
+        // must have finished, which LveRenderer::beginFrame makes sure of
+        void beginFrame(int frameIndex);
+        // size bytes of the current frame's region aligned for uniform and storage use, always
+        // in the region so they can be bound through the descriptor set. Throws when the
+        // region has no room left, the reserve is sized so that does not happen
+        Allocation allocate(VkDeviceSize size);
+        // size bytes for vertex data, from a buffer of its own when the region is full
+        Allocation allocateVertices(VkDeviceSize size);
+        template<typename T>
+        Allocation push(const T &data){
+            Allocation allocation = allocate(sizeof(T));
+            memcpy(allocation.mapped, &data, sizeof(T));
+            return allocation;
+        }
+
+        // binds the set at index set of the layout, uniformOffset and storageOffset are the
+        // offsets of allocations for binding 0 and 1
+        void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t uniformOffset, uint32_t storageOffset = 0) const;
+
+        // the current frame's region
+        VkBuffer getBuffer() const{return frames[frameIndex].region.buffer;}
+        VkDescriptorSetLayout getDescriptorSetLayout() const{return descriptorSetLayout;}
+        VkDescriptorSet getDescriptorSet() const{return frames[frameIndex].descriptorSet;}
+        VkDeviceSize getRegionSize() const{return frames[frameIndex].regionSize;}
+        // bytes the current frame has handed out so far, also the ones that did not fit
+        VkDeviceSize getUsedBytes() const{return frames[frameIndex].requested;}
+
+        private:
+            struct Buffer{
+                VkBuffer buffer{VK_NULL_HANDLE};
+                LveAllocation memory{};
+            };
+            struct Frame{
+                Buffer region;
+                VkDeviceSize regionSize{0};
+                VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+                // bytes the frame has asked for, what it asked for the last time it ran once the
+                // frame begins
+                VkDeviceSize requested{0};
+                // pieces that did not fit, freed once the frame's commands have finished
+                std::vector<Buffer> overflowBuffers;
+            };
+
+            void createDescriptorSets();
+            // (re)creates the frame's region and points its descriptor set at it
+            void createRegion(Frame &frame, VkDeviceSize regionSize);
+            Buffer createBuffer(VkDeviceSize size);
+            // the aligned offset of size bytes in the region, or false past limit
+            bool allocateInRegion(VkDeviceSize size, VkDeviceSize limit, VkDeviceSize &offset);
+            void destroyBuffer(Buffer &buffer);
+
+            LveDevice &lveDevice;
+            VkDeviceSize uniformRange;
+            VkDeviceSize storageRange;
+            VkDeviceSize alignment;
+            VkDeviceSize maxRegionSize;
+
+            VkDescriptorSetLayout descriptorSetLayout;
+            VkDescriptorPool descriptorPool;
+            std::vector<Frame> frames;
+
+            int frameIndex{0};
+            VkDeviceSize head{0};
+    };
+}
@@ -53,11 +53,8 @@ namespace lve{
 
         public:
         using id_t = unsigned int;
-        glm::vec2 speedVec{0.0f, 0.0f};
-        float radius{0.5f};
-        float mass;
-        int lastHit;
-        std::string lastWallHit{"null"};
+        // index into the LveBallStore holding this object's physics state, -1 if it has none
+        int ballIndex{-1};
      
 
         static LveGameObject createGameObject(){
@@ -65,10 +62,6 @@ namespace lve{
             return LveGameObject{currentId++};
         }
 
-        float getSpeed(){
-            return sqrt(pow(speedVec.x, 2.0f) + pow(speedVec.y, 2.0f));
-        }
-
         LveGameObject (const LveGameObject &) = delete;
         LveGameObject &operator=(const LveGameObject &) = delete;
         LveGameObject(LveGameObject &&) = default;
@@ -78,6 +71,14 @@ namespace lve{
         glm::vec3 color{}; 
         TranformComponent transform{};
 
+        // the model's bounding sphere moved by the transform, w grows with the largest scale
+        glm::vec4 getWorldBoundingSphere(){
+            glm::vec4 sphere = model->getBoundingSphere();
+            glm::vec3 center{transform.mat4() * glm::vec4{glm::vec3{sphere}, 1.0f}};
+            float scale = glm::max(glm::max(glm::abs(transform.scale.x), glm::abs(transform.scale.y)), glm::abs(transform.scale.z));
+            return {center, sphere.w * scale};
+        }
+
         id_t getId(){return id;}
         private:
         LveGameObject(id_t objId) :id{objId}{};
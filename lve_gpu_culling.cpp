@@ -0,0 +1,292 @@
+#include "lve_gpu_culling.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve{
+
+    struct CullPushConstantData{
+        glm::vec4 planes[6];
+        uint32_t objectCount;
+    };
+
+    static uint32_t packColor(glm::vec3 color){
+        uint32_t packed = 0;
+        for(int i = 0; i < 3; i++){
+            uint32_t channel = static_cast<uint32_t>(std::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+            packed |= channel << (8 * i);
+        }
+        return packed | 0xff000000u;
+    }
+
+    LveGpuCulling::LveGpuCulling(LveDevice &device) : lveDevice{device}{
+        static_assert(sizeof(LveModel::InstanceData) == 19 * sizeof(float), "cull.comp writes 19 floats per instance");
+        static_assert(sizeof(ObjectData) == 96, "ObjectData must match the std430 layout in cull.comp");
+
+        try{
+            createDescriptorSetLayout();
+            createDescriptorPool();
+            createPipelineLayout();
+            createPipeline();
+        }
+        catch(...){
+            destroyPipelineObjects();
+            throw;
+        }
+        frames.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+    }
+
+    LveGpuCulling::~LveGpuCulling(){
+        for(auto& frame : frames){
+            destroy(frame.objects);
+            destroy(frame.commands);
+            destroy(frame.counts);
+            destroy(frame.instances);
+        }
+        destroyPipelineObjects();
+    }
+
+    void LveGpuCulling::destroyPipelineObjects(){
+        vkDestroyPipeline(lveDevice.device(), pipeline, nullptr);
+        vkDestroyShaderModule(lveDevice.device(), shaderModule, nullptr);
+        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+    }
+
+    void LveGpuCulling::createDescriptorSetLayout(){
+        // objects, draw commands, draw counts and instances
+        std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+        for(uint32_t i = 0; i < bindings.size(); i++){
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if(vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create culling descriptor set layout!");
+        }
+    }
+
+    void LveGpuCulling::createDescriptorPool(){
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 4 * LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if(vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create culling descriptor pool!");
+        }
+    }
+
+    void LveGpuCulling::createPipelineLayout(){
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstantData);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if(vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create culling pipeline layout!");
+        }
+    }
+
+    void LveGpuCulling::createPipeline(){
+        auto code = LvePipeline::readFile("shaders/cull.comp.spv");
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        if(vkCreateShaderModule(lveDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS){
+            throw std::runtime_error("Failed to create shader module");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        if(vkCreateComputePipelines(lveDevice.device(), lveDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS){
+            throw std::runtime_error("failed to create culling pipeline");
+        }
+    }
+
+    bool LveGpuCulling::reserve(Buffer &buffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties){
+        if(size <= buffer.size){
+            return false;
+        }
+        // the frame's earlier commands finished before beginFrame handed it out again
+        destroy(buffer);
+        buffer.size = std::max(size, 2 * buffer.size);
+        lveDevice.createBuffer(buffer.size, usage, properties, buffer.buffer, buffer.memory);
+        buffer.mapped = buffer.memory.mapped;
+        return true;
+    }
+
+    void LveGpuCulling::destroy(Buffer &buffer){
+        if(buffer.buffer == VK_NULL_HANDLE){
+            return;
+        }
+        lveDevice.destroyBuffer(buffer.buffer, buffer.memory);
+        buffer = {};
+    }
+
+    void LveGpuCulling::writeDescriptorSet(Frame &frame){
+        if(frame.descriptorSet == VK_NULL_HANDLE){
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = descriptorPool;
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &descriptorSetLayout;
+            if(vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &frame.descriptorSet) != VK_SUCCESS){
+                throw std::runtime_error("failed to allocate culling descriptor set!");
+            }
+        }
+
+        const Buffer *buffers[] = {&frame.objects, &frame.commands, &frame.counts, &frame.instances};
+        std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 4> writes{};
+        for(uint32_t i = 0; i < writes.size(); i++){
+            bufferInfos[i].buffer = buffers[i]->buffer;
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(lveDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    void LveGpuCulling::cull(VkCommandBuffer commandBuffer, int frameIndex, std::vector<LveGameObject> &gameObjects, const LveCamera &camera){
+        Frame& frame = frames[frameIndex];
+        // the frame's previous dispatch has finished, its instance counts are what it let through
+        if(frame.commands.mapped != nullptr){
+            auto commands = static_cast<const char*>(frame.commands.mapped);
+            visibleCount = 0;
+            for(uint32_t g = 0; g < frame.groupCount; g++){
+                uint32_t instanceCount;
+                memcpy(&instanceCount, commands + DRAW_COMMAND_STRIDE * g + sizeof(uint32_t), sizeof(uint32_t));
+                visibleCount += instanceCount;
+            }
+            culledCount = frame.objectCount - visibleCount;
+        }
+
+        // groups the objects by model, the same way as the instanced path
+        drawGroups.clear();
+        groupOfModel.clear();
+        objectGroup.resize(gameObjects.size());
+        for(size_t i = 0; i < gameObjects.size(); i++){
+            LveModel *model = gameObjects[i].model.get();
+            auto inserted = groupOfModel.emplace(model, static_cast<uint32_t>(drawGroups.size()));
+            if(inserted.second){
+                drawGroups.push_back({model, 0, 0});
+            }
+            objectGroup[i] = inserted.first->second;
+            drawGroups[objectGroup[i]].objectCount++;
+        }
+        uint32_t first = 0;
+        for(auto& group : drawGroups){
+            group.firstInstance = first;
+            first += group.objectCount;
+        }
+
+        const size_t objectCount = std::max<size_t>(gameObjects.size(), 1);
+        const size_t groupCount = std::max<size_t>(drawGroups.size(), 1);
+        bool recreated = false;
+        recreated |= reserve(frame.objects, sizeof(ObjectData) * objectCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        recreated |= reserve(frame.commands, DRAW_COMMAND_STRIDE * groupCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        recreated |= reserve(frame.counts, sizeof(uint32_t) * groupCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        recreated |= reserve(frame.instances, sizeof(LveModel::InstanceData) * objectCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(recreated){
+            writeDescriptorSet(frame);
+        }
+
+        // the shader only counts instances up, so every command starts out empty
+        auto commands = static_cast<char*>(frame.commands.mapped);
+        auto counts = static_cast<uint32_t*>(frame.counts.mapped);
+        for(size_t g = 0; g < drawGroups.size(); g++){
+            LveModel *model = drawGroups[g].model;
+            if(model->hasIndexBuffer()){
+                VkDrawIndexedIndirectCommand command{model->getIndexCount(), 0, 0, 0, 0};
+                memcpy(commands + DRAW_COMMAND_STRIDE * g, &command, sizeof(command));
+            }
+            else{
+                VkDrawIndirectCommand command{model->getVertexCount(), 0, 0, 0};
+                memcpy(commands + DRAW_COMMAND_STRIDE * g, &command, sizeof(command));
+            }
+            counts[g] = 0;
+        }
+        frame.groupCount = static_cast<uint32_t>(drawGroups.size());
+        frame.objectCount = static_cast<uint32_t>(gameObjects.size());
+        auto objects = static_cast<ObjectData*>(frame.objects.mapped);
+        for(size_t i = 0; i < gameObjects.size(); i++){
+            auto& obj = gameObjects[i];
+            ObjectData& object = objects[i];
+            object.transform = obj.transform.mat4();
+            object.boundingSphere = obj.model->getBoundingSphere();
+            object.color = packColor(obj.color);
+            object.group = objectGroup[i];
+            object.firstInstance = drawGroups[objectGroup[i]].firstInstance;
+            object.padding = 0;
+        }
+        if(gameObjects.empty()){
+            return;
+        }
+
+        CullPushConstantData push{};
+        auto planes = camera.getFrustumPlanes();
+        std::copy(planes.begin(), planes.end(), push.planes);
+        push.objectCount = static_cast<uint32_t>(gameObjects.size());
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstantData), &push);
+        vkCmdDispatch(commandBuffer, (push.objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        // the draws read the commands, counts and instances the dispatch wrote, and the host
+        // reads the instance counts back the next time this frame is culled
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+}
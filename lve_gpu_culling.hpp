@@ -0,0 +1,107 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+#include "lve_game_object.hpp"
+#include "lve_camera.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace lve{
+
+    // Frustum culling on the GPU. Every frame the objects' transforms and bounding spheres
+    // go into a storage buffer, a compute pass tests them against the camera frustum and
+    // packs the visible ones into an instance buffer, counting them in one indirect draw
+    // command per model. The draw count of a model is 0 when none of its objects is visible.
+    // The commands are not compacted into one count draw: every model has its own vertex and
+    // index buffers, so each still needs its own bind and a draw with a max count of 1. The
+    // GPU decides how many instances of every model are drawn and the CPU issues one draw
+    // per model, which with the balls all sharing one model is a single draw.
+    class LveGpuCulling{
+        public:
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+        // draw commands are VkDrawIndexedIndirectCommand sized so indexed and plain models can
+        // share the buffer, instanceCount is the second member of both
+        static constexpr VkDeviceSize DRAW_COMMAND_STRIDE = sizeof(VkDrawIndexedIndirectCommand);
+
+        // one per model, its visible instances start at firstInstance in the instance buffer
+        struct DrawGroup{
+            LveModel *model;
+            uint32_t firstInstance;
+            uint32_t objectCount;
+        };
+
+        // throws when the culling pipeline cannot be built, the caller can then draw without it
+        LveGpuCulling(LveDevice &device);
+        ~LveGpuCulling();
+
+        LveGpuCulling(const LveGpuCulling&) = delete;
+        LveGpuCulling &operator=(const LveGpuCulling &) = delete;
+
+        // fills the frame's buffers and records the culling dispatch followed by a barrier
+        // for the draws. Has to be recorded outside of a render pass
+        void cull(VkCommandBuffer commandBuffer, int frameIndex, std::vector<LveGameObject> &gameObjects, const LveCamera &camera);
+
+        const std::vector<DrawGroup>& getDrawGroups() const{return drawGroups;}
+        // objects the GPU kept and dropped, read back from the dispatch this frame slot ran
+        // MAX_FRAMES_IN_FLIGHT frames ago
+        uint32_t getVisibleCount() const{return visibleCount;}
+        uint32_t getCulledCount() const{return culledCount;}
+        VkBuffer getInstanceBuffer(int frameIndex) const{return frames[frameIndex].instances.buffer;}
+        // one draw command per draw group, DRAW_COMMAND_STRIDE apart
+        VkBuffer getDrawCommandBuffer(int frameIndex) const{return frames[frameIndex].commands.buffer;}
+        // uint32_t draw count per draw group
+        VkBuffer getDrawCountBuffer(int frameIndex) const{return frames[frameIndex].counts.buffer;}
+
+        private:
+            struct ObjectData{
+                glm::mat4 transform;
+                glm::vec4 boundingSphere;
+                // rgba8
+                uint32_t color;
+                uint32_t group;
+                uint32_t firstInstance;
+                uint32_t padding;
+            };
+            struct Buffer{
+                VkBuffer buffer{VK_NULL_HANDLE};
+                LveAllocation memory{};
+                // only set for host visible buffers
+                void *mapped{nullptr};
+                VkDeviceSize size{0};
+            };
+            struct Frame{
+                Buffer objects, commands, counts, instances;
+                VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+                // what the commands buffer was last filled for
+                uint32_t groupCount{0};
+                uint32_t objectCount{0};
+            };
+
+            void createDescriptorSetLayout();
+            void createDescriptorPool();
+            void createPipelineLayout();
+            void createPipeline();
+            // what the create functions made, null handles are skipped by vkDestroy*
+            void destroyPipelineObjects();
+            // returns true when the buffer had to be recreated
+            bool reserve(Buffer &buffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+            void destroy(Buffer &buffer);
+            void writeDescriptorSet(Frame &frame);
+
+            LveDevice &lveDevice;
+            VkDescriptorSetLayout descriptorSetLayout{VK_NULL_HANDLE};
+            VkDescriptorPool descriptorPool{VK_NULL_HANDLE};
+            VkPipelineLayout pipelineLayout{VK_NULL_HANDLE};
+            VkShaderModule shaderModule{VK_NULL_HANDLE};
+            VkPipeline pipeline{VK_NULL_HANDLE};
+            std::vector<Frame> frames;
+
+            std::vector<DrawGroup> drawGroups;
+            std::unordered_map<LveModel*, uint32_t> groupOfModel;
+            std::vector<uint32_t> objectGroup;
+            uint32_t visibleCount{0};
+            uint32_t culledCount{0};
+    };
+}
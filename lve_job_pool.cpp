@@ -0,0 +1,115 @@
+#include "lve_job_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lve{
+
+    LveJobPool::LveJobPool(unsigned threadCount){
+        threadCount = std::max(threadCount, 1u);
+        for(unsigned i = 0; i < threadCount; i++){
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for(unsigned i = 1; i < threadCount; i++){
+            workers.emplace_back(&LveJobPool::workerLoop, this, i);
+        }
+    }
+
+    LveJobPool::~LveJobPool(){
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wakeCondition.notify_all();
+        for(auto& worker : workers){
+            worker.join();
+        }
+    }
+
+    void LveJobPool::parallelFor(size_t count, size_t grainSize, const Task& task){
+        if(count == 0){
+            return;
+        }
+        grainSize = std::max<size_t>(grainSize, 1);
+        const size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+        if(workers.empty() || chunkCount == 1){
+            for(size_t begin = 0; begin < count; begin += grainSize){
+                task(begin, std::min(begin + grainSize, count), 0);
+            }
+            return;
+        }
+
+        assert(pending.load() == 0 && "parallelFor is not reentrant");
+        currentTask = &task;
+        pending.store(chunkCount);
+
+        // contiguous blocks per queue, stealing only kicks in when the split turns out uneven
+        const size_t threadCount = queues.size();
+        for(size_t chunk = 0; chunk < chunkCount; chunk++){
+            size_t begin = chunk * grainSize;
+            auto& queue = *queues[chunk * threadCount / chunkCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.ranges.push_back({begin, std::min(begin + grainSize, count)});
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            generation++;
+        }
+        wakeCondition.notify_all();
+
+        while(pending.load(std::memory_order_acquire) > 0){
+            if(!runOne(0)){
+                std::this_thread::yield();
+            }
+        }
+        currentTask = nullptr;
+    }
+
+    void LveJobPool::workerLoop(unsigned worker){
+        uint64_t seenGeneration = 0;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeCondition.wait(lock, [&]{return stopping || generation != seenGeneration;});
+                if(stopping){
+                    return;
+                }
+                seenGeneration = generation;
+            }
+            while(runOne(worker)){
+            }
+        }
+    }
+
+    bool LveJobPool::runOne(unsigned worker){
+        Range range{};
+        bool found = false;
+        {
+            auto& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.ranges.empty()){
+                range = own.ranges.back();
+                own.ranges.pop_back();
+                found = true;
+            }
+        }
+        for(size_t offset = 1; !found && offset < queues.size(); offset++){
+            auto& victim = *queues[(worker + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(!victim.ranges.empty()){
+                range = victim.ranges.front();
+                victim.ranges.pop_front();
+                found = true;
+            }
+        }
+        if(!found){
+            return false;
+        }
+
+        (*currentTask)(range.begin, range.end, worker);
+        pending.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+}
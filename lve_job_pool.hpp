@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve{
+
+    // Fixed set of worker threads with one task queue each. A thread pops work from the back
+    // of its own queue and steals from the front of the others once it runs dry, so uneven
+    // chunks still keep every core busy. The calling thread takes part as worker 0.
+    class LveJobPool{
+        public:
+        using Task = std::function<void(size_t begin, size_t end, unsigned worker)>;
+
+        explicit LveJobPool(unsigned threadCount);
+        ~LveJobPool();
+
+        LveJobPool(const LveJobPool&) = delete;
+        LveJobPool &operator=(const LveJobPool&) = delete;
+
+        unsigned getThreadCount() const{return static_cast<unsigned>(queues.size());}
+
+        // runs task over [0, count) split into chunks of at most grainSize and returns once
+        // every chunk is done; worker is in [0, getThreadCount()) and unique per running chunk
+        void parallelFor(size_t count, size_t grainSize, const Task& task);
+
+        private:
+            struct Range{
+                size_t begin;
+                size_t end;
+            };
+            struct Queue{
+                std::mutex mutex;
+                std::deque<Range> ranges;
+            };
+
+            void workerLoop(unsigned worker);
+            bool runOne(unsigned worker);
+
+            std::vector<std::unique_ptr<Queue>> queues;
+            std::vector<std::thread> workers;
+
+            const Task* currentTask = nullptr;
+            std::atomic<size_t> pending{0};
+
+            std::mutex wakeMutex;
+            std::condition_variable wakeCondition;
+            uint64_t generation = 0;
+            bool stopping = false;
+    };
+}
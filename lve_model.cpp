@@ -1,40 +1,143 @@
 #include "lve_model.hpp"
-#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
 #include "lve_pipeline.hpp"
 namespace lve{
 
+    namespace{
+        struct VertexHash{
+            size_t operator()(const LveModel::Vertex &vertex) const{
+                size_t seed = 0;
+                for(int i = 0; i < 3; i++){
+                    seed ^= std::hash<float>{}(vertex.position[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+                    seed ^= std::hash<float>{}(vertex.color[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+                }
+                return seed;
+            }
+        };
+    }
+
+        void LveModel::Builder::deduplicate(){
+            if(indices.empty()){
+                indices.resize(vertices.size());
+                for(uint32_t i = 0; i < vertices.size(); i++){
+                    indices[i] = i;
+                }
+            }
+            std::vector<Vertex> uniqueVertices;
+            std::unordered_map<Vertex, uint32_t, VertexHash> indexOf;
+            for(auto& index : indices){
+                const Vertex& vertex = vertices[index];
+                auto inserted = indexOf.emplace(vertex, static_cast<uint32_t>(uniqueVertices.size()));
+                if(inserted.second){
+                    uniqueVertices.push_back(vertex);
+                }
+                index = inserted.first->second;
+            }
+            vertices = std::move(uniqueVertices);
+        }
+
          LveModel::LveModel(LveDevice& device, const std::vector<Vertex> &vertices) : lveDevice(device){
              createVertexBuffers(vertices);
+             computeBoundingSphere(vertices);
+         }
+
+         LveModel::LveModel(LveDevice& device, const Builder &builder) : lveDevice(device){
+             Builder unique = builder;
+             unique.deduplicate();
+             createVertexBuffers(unique.vertices);
+             createIndexBuffer(unique.indices);
+             computeBoundingSphere(unique.vertices);
+         }
+
+         void LveModel::computeBoundingSphere(const std::vector<Vertex> &vertices){
+             // centred on the bounding box, which is tight enough for circles and cubes
+             glm::vec3 min = vertices[0].position, max = vertices[0].position;
+             for(const auto& vertex : vertices){
+                 for(int i = 0; i < 3; i++){
+                     min[i] = std::min(min[i], vertex.position[i]);
+                     max[i] = std::max(max[i], vertex.position[i]);
+                 }
+             }
+             glm::vec3 center = (min + max) * 0.5f;
+             float radius = 0.0f;
+             for(const auto& vertex : vertices){
+                 radius = std::max(radius, glm::length(vertex.position - center));
+             }
+             boundingSphere = {center, radius};
          }
         LveModel::~LveModel(){
-                vkDestroyBuffer(lveDevice.device(), vertexBuffer, nullptr);
-                vkFreeMemory(lveDevice.device(), vertexBufferMemory, nullptr); 
+                lveDevice.destroyBuffer(vertexBuffer, vertexBufferMemory);
+                if(indexBuffer != VK_NULL_HANDLE){
+                    lveDevice.destroyBuffer(indexBuffer, indexBufferMemory);
+                }
         }
         void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices){
             vertexCount = static_cast<uint32_t>(vertices.size());
             assert(vertexCount >= 3 && "Vertex count must be at least 3");
             VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
+            // models never change after they are built, so they live in device local memory
             lveDevice.createBuffer(
                 bufferSize,
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 vertexBuffer,
                 vertexBufferMemory);
+            lveDevice.uploadBuffer(vertices.data(), bufferSize, vertexBuffer);
+        }
+
+        void LveModel::createIndexBuffer(const std::vector<uint32_t> &indices){
+            indexCount = static_cast<uint32_t>(indices.size());
+            assert(indexCount >= 3 && "Index count must be at least 3");
+
+            // 16 bit indices halve the buffer whenever every vertex is reachable with them
+            std::vector<uint16_t> shortIndices;
+            const void *indexData = indices.data();
+            VkDeviceSize bufferSize = sizeof(uint32_t) * indexCount;
+            indexType = VK_INDEX_TYPE_UINT32;
+            if(vertexCount <= UINT16_MAX + 1u){
+                shortIndices.assign(indices.begin(), indices.end());
+                indexData = shortIndices.data();
+                bufferSize = sizeof(uint16_t) * indexCount;
+                indexType = VK_INDEX_TYPE_UINT16;
+            }
 
-                void *data;
-                vkMapMemory(lveDevice.device(), vertexBufferMemory, 0 , bufferSize, 0 , &data);
-                memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-                vkUnmapMemory(lveDevice.device(), vertexBufferMemory);
+            lveDevice.createBuffer(
+                bufferSize,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                indexBuffer,
+                indexBufferMemory);
+            lveDevice.uploadBuffer(indexData, bufferSize, indexBuffer);
         }
 
         void LveModel::draw(VkCommandBuffer commandBuffer){
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
-            
+            draw(commandBuffer, 1, 0);
+        }
+        void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance){
+            if(hasIndexBuffer()){
+                vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+            }
+            else{
+                vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+            }
+        }
+        void LveModel::drawIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset){
+            if(hasIndexBuffer()){
+                lveDevice.cmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countBufferOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+            }
+            else{
+                lveDevice.cmdDrawIndirectCount(commandBuffer, buffer, offset, countBuffer, countBufferOffset, 1, sizeof(VkDrawIndirectCommand));
+            }
         }
         void LveModel::bind(VkCommandBuffer commandBuffer){
             VkBuffer buffers[] = {vertexBuffer};
             VkDeviceSize offsets[] = {0};
             vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+            if(hasIndexBuffer()){
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+            }
         }
 
         std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions(){
@@ -59,4 +162,28 @@ namespace lve{
             return attributeDescriptinos;
         }
 
+        std::vector<VkVertexInputBindingDescription> LveModel::InstanceData::getBindingDescriptions(){
+            std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+            bindingDescriptions[0].binding = 1;
+            bindingDescriptions[0].stride = sizeof(InstanceData);
+            bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            return bindingDescriptions;
+        }
+
+        std::vector<VkVertexInputAttributeDescription> LveModel::InstanceData::getAttributeDescriptions(){
+            // a mat4 attribute takes one location per column
+            std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
+            for(uint32_t column = 0; column < 4; column++){
+                attributeDescriptions[column].binding = 1;
+                attributeDescriptions[column].location = 2 + column;
+                attributeDescriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+                attributeDescriptions[column].offset = offsetof(InstanceData, transform) + column * sizeof(glm::vec4);
+            }
+            attributeDescriptions[4].binding = 1;
+            attributeDescriptions[4].location = 6;
+            attributeDescriptions[4].format = VK_FORMAT_R32G32B32_SFLOAT;
+            attributeDescriptions[4].offset = offsetof(InstanceData, color);
+            return attributeDescriptions;
+        }
+
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+
+#include <vector>
 namespace lve{
 
     class LveModel{
@@ -15,10 +17,33 @@ namespace lve{
             static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 
-            
+            bool operator==(const Vertex &other) const{
+                return position == other.position && color == other.color;
+            }
+        };
+
+        struct Builder{
+            std::vector<Vertex> vertices{};
+            // triangles as indices into vertices, empty draws the vertices in order
+            std::vector<uint32_t> indices{};
+
+            // keeps one copy of every distinct vertex and points the indices at it, also
+            // builds the indices when there are none yet
+            void deduplicate();
+        };
+
+        // per instance data of the instanced pipeline, read from binding 1
+        struct InstanceData{
+            glm::mat4 transform{1.f};
+            glm::vec3 color{};
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
         };
 
          LveModel(LveDevice &device, const std::vector<Vertex> &vertices);
+        // deduplicates the builder's vertices and draws them through an index buffer, with
+        // 16 bit indices when there are few enough vertices
+         LveModel(LveDevice &device, const Builder &builder);
         ~LveModel();
 
         LveModel(const LveModel&) = delete;
@@ -26,13 +51,32 @@ namespace lve{
 
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
+        // draws instanceCount copies reading instances firstInstance onwards from binding 1
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance);
+        // indirect draw of one command at offset, indexed when the model has an index buffer.
+        // The command is a VkDrawIndexedIndirectCommand then, a VkDrawIndirectCommand otherwise
+        void drawIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset);
+
+        uint32_t getVertexCount() const{return vertexCount;}
+        bool hasIndexBuffer() const{return indexCount > 0;}
+        uint32_t getIndexCount() const{return indexCount;}
+        // sphere around all vertices in model space, xyz is the centre and w the radius
+        const glm::vec4& getBoundingSphere() const{return boundingSphere;}
         private:
             void createVertexBuffers(const std::vector<Vertex> &vertices);
+            void createIndexBuffer(const std::vector<uint32_t> &indices);
+            void computeBoundingSphere(const std::vector<Vertex> &vertices);
             LveDevice& lveDevice;
             VkBuffer vertexBuffer;
-            VkDeviceMemory vertexBufferMemory;
+            LveAllocation vertexBufferMemory;
             uint32_t vertexCount;
 
+            VkBuffer indexBuffer{VK_NULL_HANDLE};
+            LveAllocation indexBufferMemory{};
+            VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+            uint32_t indexCount{0};
+            glm::vec4 boundingSphere{};
+
             
 
     };
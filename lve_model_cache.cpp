@@ -0,0 +1,56 @@
+#include "lve_model_cache.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace lve{
+
+    // same fan and colour gradient as FirstApp::makeCircle with the centre at the origin.
+    // Every rim point is stored once and carries the colour of the triangle that ends at
+    // it, so the gradient is interpolated across the triangles instead of flat per triangle
+    static LveModel::Builder makeUnitCircle(float angle){
+        LveModel::Builder builder{};
+        const int segments = static_cast<int>(std::ceil(2 * M_PI / angle));
+        const float times = (2 * M_PI) / angle;
+        builder.vertices.reserve(segments + 1);
+        builder.indices.reserve(3 * segments);
+
+        builder.vertices.push_back({{0.0f, 0.0f, 0.0f}, {}});
+        float color = 1.0f;
+        float colorSum = 0.0f;
+        for(int i = 0; i < segments; i++){
+            glm::vec3 point{std::cos(i * angle), -std::sin(i * angle), 0.0f};
+            if(i <= times / 2)
+                color -= 1 / (times + 2);
+            else
+                color += 1 / (times + 2);
+            colorSum += color;
+            builder.vertices.push_back({point, {color, 0.5f, 0.3f}});
+        }
+        builder.vertices[0].color = {colorSum / segments, 0.5f, 0.3f};
+
+        // rim point i + 1 is at index i + 1, the last triangle closes the fan
+        for(int i = 0; i < segments; i++){
+            uint32_t point = i + 1;
+            uint32_t prev = i == 0 ? segments : i;
+            builder.indices.push_back(0);
+            builder.indices.push_back(point);
+            builder.indices.push_back(prev);
+        }
+        return builder;
+    }
+
+    std::shared_ptr<LveModel> LveModelCache::getUnitCircle(float angle){
+        if(angle <= 0 || angle > 2 * M_PI){
+            throw std::runtime_error("Wrong angle");
+        }
+        auto found = unitCircles.find(angle);
+        if(found != unitCircles.end()){
+            return found->second;
+        }
+        auto model = std::make_shared<LveModel>(lveDevice, makeUnitCircle(angle));
+        unitCircles.emplace(angle, model);
+        return model;
+    }
+}
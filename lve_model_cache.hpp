@@ -0,0 +1,30 @@
+#pragma once
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+
+#include <map>
+#include <memory>
+
+namespace lve{
+
+    // Keeps one model per mesh so objects that only differ in size share a single
+    // vertex buffer; the size goes through TranformComponent::scale instead.
+    class LveModelCache{
+        public:
+        LveModelCache(LveDevice &device) : lveDevice{device}{}
+
+        LveModelCache(const LveModelCache&) = delete;
+        LveModelCache &operator=(const LveModelCache &) = delete;
+
+        // circle of radius 1 around the origin in the z = 0 plane, built from triangles
+        // spanning angle radians each. Built on the first request for that angle
+        std::shared_ptr<LveModel> getUnitCircle(float angle);
+
+        size_t getModelCount() const{return unitCircles.size();}
+        void clear(){unitCircles.clear();}
+
+        private:
+            LveDevice& lveDevice;
+            std::map<float, std::shared_ptr<LveModel>> unitCircles;
+    };
+}
@@ -0,0 +1,265 @@
+#include "lve_narrowphase.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LVE_NARROWPHASE_X86
+#include <immintrin.h>
+#endif
+
+namespace lve{
+
+    using SweptCircle = LveNarrowphase::SweptCircle;
+    using SweptBatch = LveNarrowphase::SweptBatch;
+
+    static constexpr float NO_IMPACT = std::numeric_limits<float>::infinity();
+
+    // Both circles are moved to the later of their two times, then |d + w * s| = reach is
+    // solved for the smaller root s. It is written as c / (-b + sqrt(b * b - a * c)), which
+    // does not lose precision when the circles are about to touch
+    static float impactTimeScalar(const SweptCircle& circle, const SweptBatch& candidates, size_t k, float maxTime){
+        float start = std::max(circle.time, candidates.time[k]);
+        float dx = (candidates.x[k] + candidates.vx[k] * (start - candidates.time[k])) - (circle.x + circle.vx * (start - circle.time));
+        float dy = (candidates.y[k] + candidates.vy[k] * (start - candidates.time[k])) - (circle.y + circle.vy * (start - circle.time));
+        float wx = candidates.vx[k] - circle.vx;
+        float wy = candidates.vy[k] - circle.vy;
+        float reach = circle.radius + candidates.radius[k];
+
+        float a = wx * wx + wy * wy;
+        float b = dx * wx + dy * wy;
+        float c = dx * dx + dy * dy - reach * reach;
+        if(b >= 0.0f){
+            return NO_IMPACT;
+        }
+        if(c <= 0.0f){
+            return start <= maxTime ? start : NO_IMPACT;
+        }
+        float discriminant = b * b - a * c;
+        if(discriminant < 0.0f){
+            return NO_IMPACT;
+        }
+        float time = start + c / (std::sqrt(discriminant) - b);
+        return time <= maxTime ? time : NO_IMPACT;
+    }
+
+    static size_t findEarliestImpactScalar(const SweptCircle& circle, const SweptBatch& candidates, size_t count,
+        float maxTime, float& impactTime){
+        size_t first = count;
+        impactTime = NO_IMPACT;
+        for(size_t k = 0; k < count; k++){
+            float time = impactTimeScalar(circle, candidates, k, maxTime);
+            if(time < impactTime){
+                impactTime = time;
+                first = k;
+            }
+        }
+        return first;
+    }
+
+    // merges the per lane results of a vector kernel with the scalar tail from k to count
+    static size_t reduceLanes(const float* laneTime, const int32_t* laneIndex, int lanes,
+        const SweptCircle& circle, const SweptBatch& candidates, size_t k, size_t count,
+        float maxTime, float& impactTime){
+        size_t first = count;
+        impactTime = NO_IMPACT;
+        for(int lane = 0; lane < lanes; lane++){
+            if(laneIndex[lane] < 0){
+                continue;
+            }
+            size_t candidate = static_cast<size_t>(laneIndex[lane]);
+            if(laneTime[lane] < impactTime || (laneTime[lane] == impactTime && candidate < first)){
+                impactTime = laneTime[lane];
+                first = candidate;
+            }
+        }
+        for(; k < count; k++){
+            float time = impactTimeScalar(circle, candidates, k, maxTime);
+            if(time < impactTime){
+                impactTime = time;
+                first = k;
+            }
+        }
+        return first;
+    }
+
+#ifdef LVE_NARROWPHASE_X86
+    // no fused multiply-add on purpose, it would round differently from the scalar kernel.
+    // The vector kernels compute the same expressions lane by lane and keep the earliest
+    // time per lane, ties go to the lower index so they pick the same candidate as the scalar one
+
+    __attribute__((target("sse2")))
+    static size_t findEarliestImpactSSE(const SweptCircle& circle, const SweptBatch& candidates, size_t count,
+        float maxTime, float& impactTime){
+        const __m128 cx = _mm_set1_ps(circle.x);
+        const __m128 cy = _mm_set1_ps(circle.y);
+        const __m128 cvx = _mm_set1_ps(circle.vx);
+        const __m128 cvy = _mm_set1_ps(circle.vy);
+        const __m128 cr = _mm_set1_ps(circle.radius);
+        const __m128 ct = _mm_set1_ps(circle.time);
+        const __m128 limit = _mm_set1_ps(maxTime);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 none = _mm_set1_ps(NO_IMPACT);
+
+        __m128 best = none;
+        __m128i bestIndex = _mm_set1_epi32(-1);
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i step = _mm_set1_epi32(4);
+        size_t k = 0;
+        for(; k + 4 <= count; k += 4){
+            __m128 kt = _mm_loadu_ps(candidates.time + k);
+            __m128 kvx = _mm_loadu_ps(candidates.vx + k);
+            __m128 kvy = _mm_loadu_ps(candidates.vy + k);
+            __m128 start = _mm_max_ps(ct, kt);
+            __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(candidates.x + k), _mm_mul_ps(kvx, _mm_sub_ps(start, kt))),
+                _mm_add_ps(cx, _mm_mul_ps(cvx, _mm_sub_ps(start, ct))));
+            __m128 dy = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(candidates.y + k), _mm_mul_ps(kvy, _mm_sub_ps(start, kt))),
+                _mm_add_ps(cy, _mm_mul_ps(cvy, _mm_sub_ps(start, ct))));
+            __m128 wx = _mm_sub_ps(kvx, cvx);
+            __m128 wy = _mm_sub_ps(kvy, cvy);
+            __m128 reach = _mm_add_ps(cr, _mm_loadu_ps(candidates.radius + k));
+
+            __m128 a = _mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy));
+            __m128 b = _mm_add_ps(_mm_mul_ps(dx, wx), _mm_mul_ps(dy, wy));
+            __m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(reach, reach));
+            __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+            __m128 swept = _mm_add_ps(start, _mm_div_ps(c, _mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(discriminant, zero)), b)));
+
+            __m128 overlapping = _mm_cmple_ps(c, zero);
+            __m128 time = _mm_or_ps(_mm_and_ps(overlapping, start), _mm_andnot_ps(overlapping, swept));
+            __m128 hit = _mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmple_ps(time, limit));
+            hit = _mm_and_ps(hit, _mm_or_ps(overlapping, _mm_cmpge_ps(discriminant, zero)));
+            time = _mm_or_ps(_mm_and_ps(hit, time), _mm_andnot_ps(hit, none));
+
+            __m128 earlier = _mm_cmplt_ps(time, best);
+            best = _mm_or_ps(_mm_and_ps(earlier, time), _mm_andnot_ps(earlier, best));
+            __m128i earlierIndex = _mm_castps_si128(earlier);
+            bestIndex = _mm_or_si128(_mm_and_si128(earlierIndex, index), _mm_andnot_si128(earlierIndex, bestIndex));
+            index = _mm_add_epi32(index, step);
+        }
+
+        alignas(16) float laneTime[4];
+        alignas(16) int32_t laneIndex[4];
+        _mm_store_ps(laneTime, best);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneIndex), bestIndex);
+        return reduceLanes(laneTime, laneIndex, 4, circle, candidates, k, count, maxTime, impactTime);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t findEarliestImpactAVX2(const SweptCircle& circle, const SweptBatch& candidates, size_t count,
+        float maxTime, float& impactTime){
+        const __m256 cx = _mm256_set1_ps(circle.x);
+        const __m256 cy = _mm256_set1_ps(circle.y);
+        const __m256 cvx = _mm256_set1_ps(circle.vx);
+        const __m256 cvy = _mm256_set1_ps(circle.vy);
+        const __m256 cr = _mm256_set1_ps(circle.radius);
+        const __m256 ct = _mm256_set1_ps(circle.time);
+        const __m256 limit = _mm256_set1_ps(maxTime);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 none = _mm256_set1_ps(NO_IMPACT);
+
+        __m256 best = none;
+        __m256i bestIndex = _mm256_set1_epi32(-1);
+        __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i step = _mm256_set1_epi32(8);
+        size_t k = 0;
+        for(; k + 8 <= count; k += 8){
+            __m256 kt = _mm256_loadu_ps(candidates.time + k);
+            __m256 kvx = _mm256_loadu_ps(candidates.vx + k);
+            __m256 kvy = _mm256_loadu_ps(candidates.vy + k);
+            __m256 start = _mm256_max_ps(ct, kt);
+            __m256 dx = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(candidates.x + k), _mm256_mul_ps(kvx, _mm256_sub_ps(start, kt))),
+                _mm256_add_ps(cx, _mm256_mul_ps(cvx, _mm256_sub_ps(start, ct))));
+            __m256 dy = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(candidates.y + k), _mm256_mul_ps(kvy, _mm256_sub_ps(start, kt))),
+                _mm256_add_ps(cy, _mm256_mul_ps(cvy, _mm256_sub_ps(start, ct))));
+            __m256 wx = _mm256_sub_ps(kvx, cvx);
+            __m256 wy = _mm256_sub_ps(kvy, cvy);
+            __m256 reach = _mm256_add_ps(cr, _mm256_loadu_ps(candidates.radius + k));
+
+            __m256 a = _mm256_add_ps(_mm256_mul_ps(wx, wx), _mm256_mul_ps(wy, wy));
+            __m256 b = _mm256_add_ps(_mm256_mul_ps(dx, wx), _mm256_mul_ps(dy, wy));
+            __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(reach, reach));
+            __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+            __m256 swept = _mm256_add_ps(start, _mm256_div_ps(c, _mm256_sub_ps(_mm256_sqrt_ps(_mm256_max_ps(discriminant, zero)), b)));
+
+            __m256 overlapping = _mm256_cmp_ps(c, zero, _CMP_LE_OQ);
+            __m256 time = _mm256_blendv_ps(swept, start, overlapping);
+            __m256 hit = _mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ), _mm256_cmp_ps(time, limit, _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_or_ps(overlapping, _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ)));
+            time = _mm256_blendv_ps(none, time, hit);
+
+            __m256 earlier = _mm256_cmp_ps(time, best, _CMP_LT_OQ);
+            best = _mm256_blendv_ps(best, time, earlier);
+            bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex),
+                _mm256_castsi256_ps(index), earlier));
+            index = _mm256_add_epi32(index, step);
+        }
+
+        alignas(32) float laneTime[8];
+        alignas(32) int32_t laneIndex[8];
+        _mm256_store_ps(laneTime, best);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex), bestIndex);
+        return reduceLanes(laneTime, laneIndex, 8, circle, candidates, k, count, maxTime, impactTime);
+    }
+#endif
+
+    LveNarrowphase::LveNarrowphase() : LveNarrowphase(bestSupportedKernel()){}
+
+    LveNarrowphase::LveNarrowphase(Kernel kernel){
+        setKernel(kernel);
+    }
+
+    void LveNarrowphase::setKernel(Kernel newKernel){
+        if(!isSupported(newKernel)){
+            throw std::runtime_error(std::string("narrowphase kernel not supported on this CPU: ") + kernelName(newKernel));
+        }
+        kernel = newKernel;
+        switch(kernel){
+#ifdef LVE_NARROWPHASE_X86
+            case Kernel::AVX2:
+                impactFunction = findEarliestImpactAVX2;
+                break;
+            case Kernel::SSE:
+                impactFunction = findEarliestImpactSSE;
+                break;
+#endif
+            default:
+                impactFunction = findEarliestImpactScalar;
+                break;
+        }
+    }
+
+    bool LveNarrowphase::isSupported(Kernel kernel){
+        switch(kernel){
+            case Kernel::Scalar: return true;
+#ifdef LVE_NARROWPHASE_X86
+            case Kernel::SSE: return __builtin_cpu_supports("sse2");
+            case Kernel::AVX2: return __builtin_cpu_supports("avx2");
+#endif
+            default: return false;
+        }
+    }
+
+    LveNarrowphase::Kernel LveNarrowphase::bestSupportedKernel(){
+        if(isSupported(Kernel::AVX2)){
+            return Kernel::AVX2;
+        }
+        if(isSupported(Kernel::SSE)){
+            return Kernel::SSE;
+        }
+        return Kernel::Scalar;
+    }
+
+    const char* LveNarrowphase::kernelName(Kernel kernel){
+        switch(kernel){
+            case Kernel::Scalar: return "scalar";
+            case Kernel::SSE: return "sse";
+            case Kernel::AVX2: return "avx2";
+        }
+        return "unknown";
+    }
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lve{
+
+    // Swept circle-circle time of impact tests over a batch of candidates.
+    // The widest kernel the CPU supports is picked at runtime: AVX2 tests 8 candidates
+    // per instruction, SSE 4, and the scalar kernel is the fallback everywhere else.
+    // All kernels give the same answer, they only differ in speed.
+    class LveNarrowphase{
+        public:
+        enum class Kernel{ Scalar, SSE, AVX2 };
+
+        // circle at (x, y) at the given time, moving in a straight line with (vx, vy)
+        struct SweptCircle{
+            float x, y, vx, vy, radius, time;
+        };
+        // the same for a batch of candidates, one array per field
+        struct SweptBatch{
+            const float *x, *y, *vx, *vy, *radius, *time;
+        };
+
+        LveNarrowphase();
+        explicit LveNarrowphase(Kernel kernel);
+
+        // index of the candidate the circle hits first, count if it hits none before maxTime.
+        // A pair is only tested from the later of the two times on, pairs that are moving
+        // apart never hit and overlapping pairs that approach hit right away
+        size_t findEarliestImpact(const SweptCircle& circle, const SweptBatch& candidates, size_t count,
+            float maxTime, float& impactTime) const{
+            return impactFunction(circle, candidates, count, maxTime, impactTime);
+        }
+
+        void setKernel(Kernel newKernel);
+        Kernel getKernel() const{return kernel;}
+
+        static bool isSupported(Kernel kernel);
+        static Kernel bestSupportedKernel();
+        static const char* kernelName(Kernel kernel);
+
+        private:
+            using ImpactFunction = size_t (*)(const SweptCircle&, const SweptBatch&, size_t, float, float&);
+
+            Kernel kernel;
+            ImpactFunction impactFunction;
+    };
+}
@@ -0,0 +1,101 @@
+#include "lve_parallel_recorder.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve{
+
+    LveParallelRecorder::LveParallelRecorder(LveDevice &device, unsigned threadCount) : lveDevice{device}, jobPool{std::max(threadCount, 1u)}{
+        pools.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for(auto& framePools : pools){
+            framePools.resize(jobPool.getThreadCount());
+            for(auto& workerPool : framePools){
+                VkCommandPoolCreateInfo poolInfo{};
+                poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+                poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                if(vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &workerPool.pool) != VK_SUCCESS){
+                    throw std::runtime_error("failed to create recording command pool!");
+                }
+            }
+        }
+    }
+
+    LveParallelRecorder::~LveParallelRecorder(){
+        // destroying a pool frees its command buffers
+        for(auto& framePools : pools){
+            for(auto& workerPool : framePools){
+                vkDestroyCommandPool(lveDevice.device(), workerPool.pool, nullptr);
+            }
+        }
+    }
+
+    VkCommandBuffer LveParallelRecorder::acquire(WorkerPool &workerPool){
+        if(workerPool.used == workerPool.commandBuffers.size()){
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = workerPool.pool;
+            allocInfo.commandBufferCount = 1;
+            VkCommandBuffer commandBuffer;
+            if(vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS){
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            workerPool.commandBuffers.push_back(commandBuffer);
+        }
+        return workerPool.commandBuffers[workerPool.used++];
+    }
+
+    void LveParallelRecorder::record(VkCommandBuffer primary, int frameIndex, const Target &target, size_t count, size_t grainSize, const RecordFunction &recordFunction){
+        if(count == 0){
+            return;
+        }
+        grainSize = std::max<size_t>(grainSize, 1);
+
+        // the frame's fence was waited on, so none of its secondary buffers is still pending
+        auto& framePools = pools[frameIndex];
+        for(auto& workerPool : framePools){
+            vkResetCommandPool(lveDevice.device(), workerPool.pool, 0);
+            workerPool.used = 0;
+        }
+
+        chunkBuffers.assign((count + grainSize - 1) / grainSize, VK_NULL_HANDLE);
+        jobPool.parallelFor(count, grainSize, [&](size_t begin, size_t end, unsigned worker){
+            VkCommandBuffer commandBuffer = acquire(framePools[worker]);
+
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.renderPass = target.renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = target.framebuffer;
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            beginInfo.pInheritanceInfo = &inheritanceInfo;
+            if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS){
+                throw std::runtime_error("failed to begin recording secondary command buffer!");
+            }
+
+            // dynamic state is not inherited from the primary
+            VkViewport viewport{};
+            viewport.width = static_cast<float>(target.extent.width);
+            viewport.height = static_cast<float>(target.extent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            VkRect2D scissor{{0, 0}, target.extent};
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+            recordFunction(commandBuffer, begin, end, worker);
+
+            if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS){
+                throw std::runtime_error("failed to record secondary command buffer!");
+            }
+            chunkBuffers[begin / grainSize] = commandBuffer;
+        });
+
+        vkCmdExecuteCommands(primary, static_cast<uint32_t>(chunkBuffers.size()), chunkBuffers.data());
+    }
+}
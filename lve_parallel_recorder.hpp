@@ -0,0 +1,57 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_job_pool.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lve{
+
+    // Records draws into secondary command buffers on several threads. Every worker thread
+    // has its own command pool per frame in flight, so threads never share a pool and a
+    // frame's pools can be reset as a whole once its fence has been waited on. The range of
+    // items is split into chunks, each chunk is recorded into its own secondary buffer and the
+    // primary executes them in chunk order, so the draw order matches a serial recording.
+    class LveParallelRecorder{
+        public:
+        // render pass instance the secondary buffers continue
+        struct Target{
+            VkRenderPass renderPass;
+            VkFramebuffer framebuffer;
+            VkExtent2D extent;
+        };
+        // records items [begin, end) into commandBuffer, called on a worker thread
+        using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end, unsigned worker)>;
+
+        LveParallelRecorder(LveDevice &device, unsigned threadCount);
+        ~LveParallelRecorder();
+
+        LveParallelRecorder(const LveParallelRecorder&) = delete;
+        LveParallelRecorder &operator=(const LveParallelRecorder &) = delete;
+
+        unsigned getThreadCount() const{return jobPool.getThreadCount();}
+
+        // records count items in chunks of grainSize and executes them in primary, which has
+        // to be inside target's render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+        // Viewport and scissor are set to target.extent in every secondary buffer
+        void record(VkCommandBuffer primary, int frameIndex, const Target &target, size_t count, size_t grainSize, const RecordFunction &recordFunction);
+
+        private:
+            // one worker's command pool for one frame and the secondary buffers it handed out
+            struct WorkerPool{
+                VkCommandPool pool{VK_NULL_HANDLE};
+                std::vector<VkCommandBuffer> commandBuffers;
+                size_t used{0};
+            };
+
+            VkCommandBuffer acquire(WorkerPool &workerPool);
+
+            LveDevice &lveDevice;
+            LveJobPool jobPool;
+            // [frame][worker]
+            std::vector<std::vector<WorkerPool>> pools;
+            std::vector<VkCommandBuffer> chunkBuffers;
+    };
+}
@@ -9,17 +9,42 @@ namespace lve{
  LvePipeline::LvePipeline( LveDevice &device,
  const std::string& vertFilepath, 
  const std::string& fragFilepath, 
- const PipelineConfiguInfo& configInfo): lveDevice{device}{
-     createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+ const PipelineConfiguInfo& configInfo): LvePipeline{device,
+     std::make_shared<LveShaderModule>(device, vertFilepath),
+     std::make_shared<LveShaderModule>(device, fragFilepath),
+     configInfo}{
+ }
+
+ LvePipeline::LvePipeline(LveDevice &device,
+ std::shared_ptr<LveShaderModule> vertModule,
+ std::shared_ptr<LveShaderModule> fragModule,
+ const PipelineConfiguInfo& configInfo,
+ const SpecializationConstants &constants): lveDevice{device}, vertShaderModule{std::move(vertModule)}, fragShaderModule{std::move(fragModule)}{
+     createGraphicsPipeline(configInfo, constants);
  }
 
  LvePipeline::~LvePipeline(){
-    vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-    vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
     vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
 
  }
 
+ LveShaderModule::LveShaderModule(LveDevice &device, const std::string& filepath): lveDevice{device}{
+     auto code = LvePipeline::readFile(filepath);
+
+     VkShaderModuleCreateInfo createInfo{};
+     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+     createInfo.codeSize = code.size();
+     createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+     if(vkCreateShaderModule(lveDevice.device(), &createInfo ,nullptr, &shaderModule) != VK_SUCCESS){
+         throw std::runtime_error("Failed to create shader module");
+     }
+ }
+
+ LveShaderModule::~LveShaderModule(){
+     vkDestroyShaderModule(lveDevice.device(), shaderModule, nullptr);
+ }
+
      std::vector<char> LvePipeline::readFile(const std::string& filepath){
 
          std::ifstream file{filepath, std::ios::ate | std::ios::binary};
@@ -36,38 +61,40 @@ namespace lve{
          return buffer;
      }
 
-     void LvePipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath,  const PipelineConfiguInfo& configInfo){
+     void LvePipeline::createGraphicsPipeline(const PipelineConfiguInfo& configInfo, const SpecializationConstants &constants){
    
          assert(
              configInfo.pipelineLayout != VK_NULL_HANDLE && 
              "Cannot create grahpics pieline: no pipelineLayout provided in configInfo");
          assert(configInfo.renderPass != VK_NULL_HANDLE && 
          "Cannot create grahpics pipeline:: no renderPass provided in configInfo");
-         auto vertCode = readFile(vertFilepath);
-         auto fragCode = readFile(fragFilepath);
 
-        createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+        VkSpecializationInfo specializationInfo{};
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(constants.entries.size());
+        specializationInfo.pMapEntries = constants.entries.data();
+        specializationInfo.dataSize = constants.data.size();
+        specializationInfo.pData = constants.data.data();
+        const VkSpecializationInfo* pSpecializationInfo = constants.entries.empty() ? nullptr : &specializationInfo;
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-        shaderStages[0].module = vertShaderModule;
+        shaderStages[0].module = vertShaderModule->getModule();
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo = pSpecializationInfo;
          
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        shaderStages[1].module = fragShaderModule;
+        shaderStages[1].module = fragShaderModule->getModule();
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
+        shaderStages[1].pSpecializationInfo = pSpecializationInfo;
 
-        auto bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions(); 
+        auto& bindingDescriptions = configInfo.bindingDescriptions;
+        auto& attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertexInputInfo.vertexAttributeDescriptionCount =static_cast<uint32_t>(attributeDescriptions.size());
@@ -98,7 +125,7 @@ namespace lve{
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if(vkCreateGraphicsPipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS){
+        if(vkCreateGraphicsPipelines(lveDevice.device(), lveDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS){
             throw std::runtime_error("failed to create grahpics pipeline");
         }
 
@@ -106,17 +133,6 @@ namespace lve{
 
      }
 
-     void LvePipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule){
-         VkShaderModuleCreateInfo createInfo{};
-         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-         createInfo.codeSize = code.size();
-         createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-         if(vkCreateShaderModule(lveDevice.device(), &createInfo ,nullptr, shaderModule) != VK_SUCCESS){
-             throw std::runtime_error("Failed to create shader module");
-         }
-     }
-
      void LvePipeline::bind(VkCommandBuffer commandBuffer){
         
          vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline );
@@ -201,6 +217,9 @@ namespace lve{
        configInfo.dynamicsStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
        configInfo.dynamicsStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
        configInfo.dynamicsStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+
+       configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+       configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
      }
 
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstring>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include "lve_device.hpp"
 
@@ -21,13 +24,55 @@ namespace lve
         VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
         std::vector<VkDynamicState> dynamicStateEnables;
         VkPipelineDynamicStateCreateInfo dynamicsStateInfo;
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
     };
+
+    // values for the shaders' constant_id constants, baked into the pipeline when it is built.
+    // Both stages get the same constants, ids a stage does not declare are ignored
+    struct SpecializationConstants{
+        template<typename T>
+        void set(uint32_t constantID, const T &value){
+            static_assert(std::is_trivially_copyable<T>::value, "specialization constants are plain values");
+            // GLSL bools are 32 bits
+            static_assert(!std::is_same<T, bool>::value, "use VkBool32 for bool constants");
+            VkSpecializationMapEntry entry{};
+            entry.constantID = constantID;
+            entry.offset = static_cast<uint32_t>(data.size());
+            entry.size = sizeof(T);
+            entries.push_back(entry);
+            data.resize(data.size() + sizeof(T));
+            memcpy(data.data() + entry.offset, &value, sizeof(T));
+        }
+
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<char> data;
+    };
+
+    class LveShaderModule{
+        public:
+        LveShaderModule(LveDevice &device, const std::string& filepath);
+        ~LveShaderModule();
+
+        LveShaderModule(const LveShaderModule&) = delete;
+        LveShaderModule &operator=(const LveShaderModule &) = delete;
+
+        VkShaderModule getModule() const{return shaderModule;}
+
+        private:
+            LveDevice& lveDevice;
+            VkShaderModule shaderModule;
+    };
+
     class LvePipeline{
         public:
         LvePipeline( LveDevice &device,const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfiguInfo& configInfo);
+        // shader modules may be shared with other pipelines, they are kept alive as long as this one
+        LvePipeline(LveDevice &device, std::shared_ptr<LveShaderModule> vertModule, std::shared_ptr<LveShaderModule> fragModule,
+            const PipelineConfiguInfo& configInfo, const SpecializationConstants &constants = {});
 
         ~LvePipeline();
 
@@ -37,16 +82,14 @@ namespace lve
         void bind(VkCommandBuffer commandBuffer);
 
         static void defaultPipelineConfigInfo(PipelineConfiguInfo& configInfo);
+        static std::vector<char> readFile(const std::string& filepath);
         private:
-            static std::vector<char> readFile(const std::string& filepath);
-
-            void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath,  const PipelineConfiguInfo& configInfo);
 
-            void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+            void createGraphicsPipeline(const PipelineConfiguInfo& configInfo, const SpecializationConstants &constants);
 
             LveDevice& lveDevice;
             VkPipeline graphicsPipeline;
-            VkShaderModule vertShaderModule;
-            VkShaderModule fragShaderModule;
+            std::shared_ptr<LveShaderModule> vertShaderModule;
+            std::shared_ptr<LveShaderModule> fragShaderModule;
     };
 } // namespace lve
@@ -0,0 +1,127 @@
+#include "lve_pipeline_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve{
+
+    LvePipelineCache::LvePipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties, const std::string &path)
+        : device{device}, properties{properties}, path{path}{
+        std::vector<char> data;
+        try{
+            data = load();
+        }
+        catch(const std::exception &e){
+            std::cerr << "pipeline cache not loaded: " << e.what() << std::endl;
+            data.clear();
+        }
+        loaded = !data.empty();
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+        if(vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS){
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+    }
+
+    LvePipelineCache::~LvePipelineCache(){
+        try{
+            save();
+        }
+        catch(const std::exception &e){
+            std::cerr << "pipeline cache not saved: " << e.what() << std::endl;
+        }
+        vkDestroyPipelineCache(device, cache, nullptr);
+    }
+
+    uint64_t LvePipelineCache::checksum(const std::vector<char> &data){
+        // FNV-1a, only meant to catch truncated or damaged files
+        uint64_t hash = 14695981039346656037ull;
+        for(char c : data){
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    LvePipelineCache::FileHeader LvePipelineCache::makeHeader(const std::vector<char> &data) const{
+        FileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.dataSize = data.size();
+        header.checksum = checksum(data);
+        return header;
+    }
+
+    std::vector<char> LvePipelineCache::load() const{
+        std::ifstream file{path, std::ios::binary | std::ios::ate};
+        if(!file.is_open()){
+            return {};
+        }
+        std::streamoff fileSize = file.tellg();
+        file.seekg(0);
+        FileHeader header{};
+        if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))){
+            return {};
+        }
+        if(header.magic != MAGIC || header.version != VERSION){
+            return {};
+        }
+        if(header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+           header.driverVersion != properties.driverVersion ||
+           memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0){
+            std::cerr << "pipeline cache " << path << " belongs to another device or driver, starting empty" << std::endl;
+            return {};
+        }
+
+        // checked before allocating, the header may be damaged too
+        if(fileSize < 0 || header.dataSize != static_cast<uint64_t>(fileSize) - sizeof(header)){
+            std::cerr << "pipeline cache " << path << " is damaged, starting empty" << std::endl;
+            return {};
+        }
+        std::vector<char> data(header.dataSize);
+        if(!file.read(data.data(), data.size()) || checksum(data) != header.checksum){
+            std::cerr << "pipeline cache " << path << " is damaged, starting empty" << std::endl;
+            return {};
+        }
+        return data;
+    }
+
+    void LvePipelineCache::save(){
+        size_t size = 0;
+        if(vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS){
+            throw std::runtime_error("failed to get pipeline cache size!");
+        }
+        std::vector<char> data(size);
+        if(vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS){
+            throw std::runtime_error("failed to get pipeline cache data!");
+        }
+        data.resize(size);
+
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+            if(!file.is_open()){
+                throw std::runtime_error("failed to open file: " + tempPath);
+            }
+            FileHeader header = makeHeader(data);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(data.data(), data.size());
+            if(!file){
+                throw std::runtime_error("failed to write file: " + tempPath);
+            }
+        }
+        if(std::rename(tempPath.c_str(), path.c_str()) != 0){
+            throw std::runtime_error("failed to replace file: " + path);
+        }
+    }
+}
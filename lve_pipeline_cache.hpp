@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve{
+
+    // VkPipelineCache kept in a file between runs. The file starts with a header naming the
+    // device, driver version and pipelineCacheUUID it was written for; data written for any
+    // other device or driver, or that is cut short, is ignored and the cache starts empty.
+    // The cache is written back by save() and by the destructor.
+    class LvePipelineCache{
+        public:
+        LvePipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties, const std::string &path);
+        ~LvePipelineCache();
+
+        LvePipelineCache(const LvePipelineCache&) = delete;
+        LvePipelineCache &operator=(const LvePipelineCache &) = delete;
+
+        VkPipelineCache getCache() const{return cache;}
+        // true when the cache started from the file's data
+        bool wasLoaded() const{return loaded;}
+        // writes to a temporary file first, so a crash while saving keeps the old file
+        void save();
+
+        private:
+            struct FileHeader{
+                uint32_t magic;
+                uint32_t version;
+                uint32_t vendorID;
+                uint32_t deviceID;
+                uint32_t driverVersion;
+                uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+                uint64_t dataSize;
+                uint64_t checksum;
+            };
+            static constexpr uint32_t MAGIC = 0x4c564350; // "LVCP"
+            static constexpr uint32_t VERSION = 1;
+
+            std::vector<char> load() const;
+            FileHeader makeHeader(const std::vector<char> &data) const;
+            static uint64_t checksum(const std::vector<char> &data);
+
+            VkDevice device;
+            VkPhysicalDeviceProperties properties;
+            std::string path;
+            VkPipelineCache cache;
+            bool loaded{false};
+    };
+}
@@ -0,0 +1,75 @@
+#include "lve_pipeline_compiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace lve{
+
+    LvePipelineCompiler::LvePipelineCompiler(LvePipelineVariants &variants, unsigned threadCount) : variants{variants}{
+        threadCount = std::max(threadCount, 1u);
+        for(unsigned i = 0; i < threadCount; i++){
+            workers.emplace_back([this]{workerLoop();});
+        }
+    }
+
+    LvePipelineCompiler::~LvePipelineCompiler(){
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+            tasks.clear();
+        }
+        wakeCondition.notify_all();
+        for(auto& worker : workers){
+            worker.join();
+        }
+    }
+
+    LvePipelineCompiler::PipelineFuture LvePipelineCompiler::compile(const std::string &vertFilepath, const std::string &fragFilepath, ConfigFunction configFunction,
+        SpecializationConstants constants){
+        std::packaged_task<std::shared_ptr<LvePipeline>()> task{
+            [this, vertFilepath, fragFilepath, configFunction, constants]{
+                PipelineConfiguInfo configInfo{};
+                configFunction(configInfo);
+                return variants.get(vertFilepath, fragFilepath, configInfo, constants);
+            }};
+        PipelineFuture future = task.get_future().share();
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            tasks.push_back(std::move(task));
+        }
+        wakeCondition.notify_one();
+        return future;
+    }
+
+    std::shared_ptr<LvePipeline> LvePipelineCompiler::getIfReady(const PipelineFuture &future){
+        if(!future.valid() || future.wait_for(std::chrono::seconds{0}) != std::future_status::ready){
+            return nullptr;
+        }
+        return future.get();
+    }
+
+    size_t LvePipelineCompiler::getPendingCount() const{
+        std::lock_guard<std::mutex> lock{mutex};
+        return tasks.size() + runningCount;
+    }
+
+    void LvePipelineCompiler::workerLoop(){
+        while(true){
+            std::packaged_task<std::shared_ptr<LvePipeline>()> task;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                wakeCondition.wait(lock, [this]{return stopping || !tasks.empty();});
+                if(stopping){
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                runningCount++;
+            }
+            // exceptions end up in the future
+            task();
+            std::lock_guard<std::mutex> lock{mutex};
+            runningCount--;
+        }
+    }
+}
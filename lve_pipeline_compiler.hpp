@@ -0,0 +1,57 @@
+#pragma once
+
+#include "lve_pipeline.hpp"
+#include "lve_pipeline_variants.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve{
+
+    // Builds graphics pipelines on background threads so a new pipeline never stalls a frame.
+    // compile() returns right away with a future; the render loop keeps drawing without the
+    // pipeline, or with a fallback, until getIfReady hands it over. Pipelines are built through
+    // variants, so compiling a variant twice builds it once, and through the device's pipeline
+    // cache, which Vulkan synchronizes internally.
+    class LvePipelineCompiler{
+        public:
+        using PipelineFuture = std::shared_future<std::shared_ptr<LvePipeline>>;
+        // fills the configuration on the worker thread, PipelineConfiguInfo cannot be copied
+        // there because it points into itself
+        using ConfigFunction = std::function<void(PipelineConfiguInfo &configInfo)>;
+
+        LvePipelineCompiler(LvePipelineVariants &variants, unsigned threadCount);
+        // pipelines still waiting in the queue are dropped, their futures throw
+        // std::future_error with broken_promise
+        ~LvePipelineCompiler();
+
+        LvePipelineCompiler(const LvePipelineCompiler&) = delete;
+        LvePipelineCompiler &operator=(const LvePipelineCompiler &) = delete;
+
+        PipelineFuture compile(const std::string &vertFilepath, const std::string &fragFilepath, ConfigFunction configFunction,
+            SpecializationConstants constants = {});
+        // the pipeline once it is built and nullptr before, rethrows when building it failed
+        static std::shared_ptr<LvePipeline> getIfReady(const PipelineFuture &future);
+        // pipelines queued or being built
+        size_t getPendingCount() const;
+        LvePipelineVariants &getVariants(){return variants;}
+
+        private:
+            void workerLoop();
+
+            LvePipelineVariants &variants;
+            std::vector<std::thread> workers;
+            mutable std::mutex mutex;
+            std::condition_variable wakeCondition;
+            std::deque<std::packaged_task<std::shared_ptr<LvePipeline>()>> tasks;
+            size_t runningCount{0};
+            bool stopping{false};
+    };
+}
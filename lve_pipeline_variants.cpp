@@ -0,0 +1,174 @@
+#include "lve_pipeline_variants.hpp"
+
+namespace lve{
+
+    namespace{
+        template<typename T>
+        void appendKey(std::string &key, const T &value){
+            key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+    }
+
+    LvePipelineVariants::LvePipelineVariants(LveDevice &device) : lveDevice{device}{}
+
+    std::string LvePipelineVariants::makeKey(const std::string &vertFilepath, const std::string &fragFilepath,
+        const PipelineConfiguInfo &configInfo, const SpecializationConstants &constants){
+        // only the state createGraphicsPipeline reads, field by field so padding and the
+        // pointers the config keeps into itself do not end up in the key
+        std::string key;
+        appendKey(key, vertFilepath.size());
+        key += vertFilepath;
+        appendKey(key, fragFilepath.size());
+        key += fragFilepath;
+
+        appendKey(key, configInfo.inputAssemblyInfo.topology);
+        appendKey(key, configInfo.inputAssemblyInfo.primitiveRestartEnable);
+
+        auto& raster = configInfo.rasterizationInfo;
+        appendKey(key, raster.depthClampEnable);
+        appendKey(key, raster.rasterizerDiscardEnable);
+        appendKey(key, raster.polygonMode);
+        appendKey(key, raster.lineWidth);
+        appendKey(key, raster.cullMode);
+        appendKey(key, raster.frontFace);
+        appendKey(key, raster.depthBiasEnable);
+        appendKey(key, raster.depthBiasConstantFactor);
+        appendKey(key, raster.depthBiasClamp);
+        appendKey(key, raster.depthBiasSlopeFactor);
+
+        auto& multisample = configInfo.multisampleInfo;
+        appendKey(key, multisample.rasterizationSamples);
+        appendKey(key, multisample.sampleShadingEnable);
+        appendKey(key, multisample.minSampleShading);
+        appendKey(key, multisample.alphaToCoverageEnable);
+        appendKey(key, multisample.alphaToOneEnable);
+
+        auto& blend = configInfo.colorBlendAttachment;
+        appendKey(key, blend.blendEnable);
+        appendKey(key, blend.srcColorBlendFactor);
+        appendKey(key, blend.dstColorBlendFactor);
+        appendKey(key, blend.colorBlendOp);
+        appendKey(key, blend.srcAlphaBlendFactor);
+        appendKey(key, blend.dstAlphaBlendFactor);
+        appendKey(key, blend.alphaBlendOp);
+        appendKey(key, blend.colorWriteMask);
+        appendKey(key, configInfo.colorBlendInfo.logicOpEnable);
+        appendKey(key, configInfo.colorBlendInfo.logicOp);
+        appendKey(key, configInfo.colorBlendInfo.blendConstants);
+
+        auto& depth = configInfo.depthStencilInfo;
+        appendKey(key, depth.depthTestEnable);
+        appendKey(key, depth.depthWriteEnable);
+        appendKey(key, depth.depthCompareOp);
+        appendKey(key, depth.depthBoundsTestEnable);
+        appendKey(key, depth.minDepthBounds);
+        appendKey(key, depth.maxDepthBounds);
+        appendKey(key, depth.stencilTestEnable);
+
+        appendKey(key, configInfo.dynamicStateEnables.size());
+        for(auto state : configInfo.dynamicStateEnables){
+            appendKey(key, state);
+        }
+        appendKey(key, configInfo.bindingDescriptions.size());
+        for(auto& binding : configInfo.bindingDescriptions){
+            appendKey(key, binding.binding);
+            appendKey(key, binding.stride);
+            appendKey(key, binding.inputRate);
+        }
+        appendKey(key, configInfo.attributeDescriptions.size());
+        for(auto& attribute : configInfo.attributeDescriptions){
+            appendKey(key, attribute.location);
+            appendKey(key, attribute.binding);
+            appendKey(key, attribute.format);
+            appendKey(key, attribute.offset);
+        }
+
+        appendKey(key, configInfo.pipelineLayout);
+        appendKey(key, configInfo.renderPass);
+        appendKey(key, configInfo.subpass);
+
+        appendKey(key, constants.entries.size());
+        for(auto& entry : constants.entries){
+            appendKey(key, entry.constantID);
+            appendKey(key, entry.offset);
+            appendKey(key, entry.size);
+        }
+        key.append(constants.data.data(), constants.data.size());
+        return key;
+    }
+
+    std::shared_ptr<LveShaderModule> LvePipelineVariants::getShaderModule(const std::string &filepath){
+        std::unique_lock<std::mutex> lock{mutex};
+        auto it = shaderModules.find(filepath);
+        if(it != shaderModules.end()){
+            auto future = it->second;
+            lock.unlock();
+            return future.get();
+        }
+        std::promise<std::shared_ptr<LveShaderModule>> promise;
+        shaderModules.emplace(filepath, promise.get_future().share());
+        // the file is read and the module created outside the lock, like the pipelines
+        lock.unlock();
+
+        try{
+            auto shaderModule = std::make_shared<LveShaderModule>(lveDevice, filepath);
+            promise.set_value(shaderModule);
+            return shaderModule;
+        }
+        catch(...){
+            promise.set_exception(std::current_exception());
+            lock.lock();
+            shaderModules.erase(filepath);
+            throw;
+        }
+    }
+
+    std::shared_ptr<LvePipeline> LvePipelineVariants::get(const std::string &vertFilepath, const std::string &fragFilepath,
+        const PipelineConfiguInfo &configInfo, const SpecializationConstants &constants){
+        std::string key = makeKey(vertFilepath, fragFilepath, configInfo, constants);
+
+        std::unique_lock<std::mutex> lock{mutex};
+        requests++;
+        auto it = pipelines.find(key);
+        if(it != pipelines.end()){
+            auto future = it->second;
+            // unlocked before waiting so the thread building it is not blocked
+            lock.unlock();
+            return future.get();
+        }
+        std::promise<std::shared_ptr<LvePipeline>> promise;
+        pipelines.emplace(key, promise.get_future().share());
+        // built outside the lock so different variants are built at the same time
+        lock.unlock();
+
+        try{
+            auto vertModule = getShaderModule(vertFilepath);
+            auto fragModule = getShaderModule(fragFilepath);
+            auto pipeline = std::make_shared<LvePipeline>(lveDevice, vertModule, fragModule, configInfo, constants);
+            promise.set_value(pipeline);
+            return pipeline;
+        }
+        catch(...){
+            promise.set_exception(std::current_exception());
+            // a later request tries again
+            lock.lock();
+            pipelines.erase(key);
+            throw;
+        }
+    }
+
+    void LvePipelineVariants::clear(){
+        std::lock_guard<std::mutex> lock{mutex};
+        pipelines.clear();
+        shaderModules.clear();
+    }
+
+    LvePipelineVariants::Stats LvePipelineVariants::getStats() const{
+        std::lock_guard<std::mutex> lock{mutex};
+        Stats stats{};
+        stats.requests = requests;
+        stats.pipelines = pipelines.size();
+        stats.shaderModules = shaderModules.size();
+        return stats;
+    }
+}
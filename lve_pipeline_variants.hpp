@@ -0,0 +1,49 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_pipeline.hpp"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace lve{
+
+    // Pipelines keyed by their shaders, fixed function state and specialization constants.
+    // Asking twice for the same variant returns the pipeline built the first time, and every
+    // variant of a shader shares one shader module. Safe to call from several threads, a
+    // variant requested while another thread builds it waits for that build.
+    class LvePipelineVariants{
+        public:
+        struct Stats{
+            size_t requests{0};
+            size_t pipelines{0};
+            size_t shaderModules{0};
+        };
+
+        LvePipelineVariants(LveDevice &device);
+
+        LvePipelineVariants(const LvePipelineVariants&) = delete;
+        LvePipelineVariants &operator=(const LvePipelineVariants &) = delete;
+
+        std::shared_ptr<LvePipeline> get(const std::string &vertFilepath, const std::string &fragFilepath,
+            const PipelineConfiguInfo &configInfo, const SpecializationConstants &constants = {});
+        // drops the cached pipelines and modules, ones still held by callers stay alive
+        void clear();
+        Stats getStats() const;
+
+        private:
+            static std::string makeKey(const std::string &vertFilepath, const std::string &fragFilepath,
+                const PipelineConfiguInfo &configInfo, const SpecializationConstants &constants);
+            std::shared_ptr<LveShaderModule> getShaderModule(const std::string &filepath);
+
+            LveDevice &lveDevice;
+            mutable std::mutex mutex;
+            std::unordered_map<std::string, std::shared_future<std::shared_ptr<LvePipeline>>> pipelines;
+            // a module being loaded is already in the map, so a second thread waits for it
+            std::unordered_map<std::string, std::shared_future<std::shared_ptr<LveShaderModule>>> shaderModules;
+            size_t requests{0};
+    };
+}
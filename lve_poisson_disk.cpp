@@ -0,0 +1,110 @@
+#include "lve_poisson_disk.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace lve{
+
+    LvePoissonDisk::LvePoissonDisk(float minX, float minY, float maxX, float maxY, float minDistance)
+        : minX{minX}, minY{minY}, maxX{maxX}, maxY{maxY}, minDistance{minDistance}{
+        if(minDistance <= 0.0f || maxX < minX || maxY < minY){
+            throw std::runtime_error("invalid poisson disk region");
+        }
+    }
+
+    size_t LvePoissonDisk::cellIndex(glm::vec2 point) const{
+        int column = std::min(static_cast<int>((point.x - minX) / cellSize), columns - 1);
+        int row = std::min(static_cast<int>((point.y - minY) / cellSize), rows - 1);
+        return static_cast<size_t>(row) * columns + column;
+    }
+
+    bool LvePoissonDisk::isFree(glm::vec2 point) const{
+        if(point.x < minX || point.x > maxX || point.y < minY || point.y > maxY){
+            return false;
+        }
+        int column = std::min(static_cast<int>((point.x - minX) / cellSize), columns - 1);
+        int row = std::min(static_cast<int>((point.y - minY) / cellSize), rows - 1);
+        // points closer than spacing are at most two cells away
+        for(int y = std::max(row - 2, 0); y <= std::min(row + 2, rows - 1); y++){
+            for(int x = std::max(column - 2, 0); x <= std::min(column + 2, columns - 1); x++){
+                uint32_t other = cells[static_cast<size_t>(y) * columns + x];
+                if(other == 0){
+                    continue;
+                }
+                glm::vec2 d = points[other - 1] - point;
+                if(d.x * d.x + d.y * d.y < spacing * spacing){
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    std::vector<glm::vec2> LvePoissonDisk::fill(std::mt19937_64& rng){
+        fill(rng, minDistance, std::numeric_limits<size_t>::max());
+        return points;
+    }
+
+    std::vector<glm::vec2> LvePoissonDisk::sample(size_t count, std::mt19937_64& rng){
+        if(count == 0){
+            return {};
+        }
+        // a fill that ends short gets tried again a bit closer, the last one at minDistance
+        float tryDistance = spacingFor(count);
+        while(true){
+            fill(rng, tryDistance, count);
+            if(points.size() == count || tryDistance == minDistance){
+                return points;
+            }
+            tryDistance = std::max(0.9f * tryDistance, minDistance);
+        }
+    }
+
+    float LvePoissonDisk::spacingFor(size_t count) const{
+        float area = (maxX - minX) * (maxY - minY);
+        return std::max(std::sqrt(FILL_DENSITY * area / static_cast<float>(std::max<size_t>(count, 1))), minDistance);
+    }
+
+    void LvePoissonDisk::fill(std::mt19937_64& rng, float newSpacing, size_t maxCount){
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        spacing = newSpacing;
+        // a cell's diagonal is the spacing, so no two points can share a cell
+        cellSize = spacing / std::sqrt(2.0f);
+        columns = static_cast<int>((maxX - minX) / cellSize) + 1;
+        rows = static_cast<int>((maxY - minY) / cellSize) + 1;
+        cells.assign(static_cast<size_t>(columns) * rows, 0);
+        points.clear();
+
+        std::vector<uint32_t> active;
+        auto place = [&](glm::vec2 point){
+            points.push_back(point);
+            cells[cellIndex(point)] = static_cast<uint32_t>(points.size());
+            active.push_back(static_cast<uint32_t>(points.size() - 1));
+        };
+        place({minX + (maxX - minX) * unit(rng), minY + (maxY - minY) * unit(rng)});
+
+        const float twoPi = 6.28318530718f;
+        while(!active.empty() && points.size() < maxCount){
+            size_t slot = std::min(static_cast<size_t>(unit(rng) * active.size()), active.size() - 1);
+            glm::vec2 origin = points[active[slot]];
+            bool placed = false;
+            for(int i = 0; i < CANDIDATES_PER_POINT; i++){
+                // uniform over the area of the ring between spacing and 2 * spacing
+                float distance = spacing * std::sqrt(1.0f + 3.0f * unit(rng));
+                float angle = twoPi * unit(rng);
+                glm::vec2 candidate = origin + distance * glm::vec2{std::cos(angle), std::sin(angle)};
+                if(isFree(candidate)){
+                    place(candidate);
+                    placed = true;
+                    break;
+                }
+            }
+            if(!placed){
+                active[slot] = active.back();
+                active.pop_back();
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace lve{
+
+    // Bridson's Poisson-disk sampling over a rectangle. Points are grown outwards from
+    // the ones already placed and checked against a background grid whose cells hold at
+    // most one point, so placing n points is O(n) instead of testing every earlier point.
+    // sample() spreads a requested number of points: it spaces them for that density over
+    // the rectangle, never closer than minDistance, and stops once all of them are placed.
+    class LvePoissonDisk{
+        public:
+        // new points tried around an active point before it is retired
+        static constexpr int CANDIDATES_PER_POINT = 30;
+        // points times spacing squared per area a fill stays under, a full fill reaches about 0.62
+        static constexpr float FILL_DENSITY = 0.6f;
+
+        LvePoissonDisk(float minX, float minY, float maxX, float maxY, float minDistance);
+
+        // points at least minDistance apart until no more fit anywhere in the rectangle
+        std::vector<glm::vec2> fill(std::mt19937_64& rng);
+        // count points spread over the whole rectangle, spaced by spacingFor(count). Returns
+        // fewer when the rectangle cannot hold count points minDistance apart
+        std::vector<glm::vec2> sample(size_t count, std::mt19937_64& rng);
+        // spacing at which a fill of the rectangle holds about count points, at least minDistance
+        float spacingFor(size_t count) const;
+
+        private:
+            // points at least newSpacing apart until maxCount are placed or no more fit
+            void fill(std::mt19937_64& rng, float newSpacing, size_t maxCount);
+            bool isFree(glm::vec2 point) const;
+            size_t cellIndex(glm::vec2 point) const;
+
+            float minX, minY, maxX, maxY;
+            float minDistance;
+            // of the last fill
+            float spacing;
+            float cellSize;
+            int columns, rows;
+            // index + 1 of the point in every cell, 0 while it is empty
+            std::vector<uint32_t> cells;
+            std::vector<glm::vec2> points;
+    };
+}
@@ -0,0 +1,89 @@
+#include "lve_render_queue.hpp"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve{
+
+    LveRenderQueue::BindCounts &LveRenderQueue::BindCounts::operator+=(const BindCounts &other){
+        draws += other.draws;
+        pipelineBinds += other.pipelineBinds;
+        modelBinds += other.modelBinds;
+        redundantPipelineBinds += other.redundantPipelineBinds;
+        redundantModelBinds += other.redundantModelBinds;
+        return *this;
+    }
+
+    void LveRenderQueue::clear(){
+        entries.clear();
+        pipelines.clear();
+        models.clear();
+        pipelineIds.clear();
+        modelIds.clear();
+        lastAddedModel = nullptr;
+        unsortedModelBinds = 0;
+    }
+
+    void LveRenderQueue::add(LvePipeline *pipeline, LveModel *model, float depth, uint32_t item){
+        auto pipelineId = pipelineIds.emplace(pipeline, static_cast<uint32_t>(pipelines.size()));
+        if(pipelineId.second){
+            if(pipelines.size() == MAX_PIPELINES){
+                throw std::runtime_error("too many pipelines in render queue!");
+            }
+            pipelines.push_back(pipeline);
+        }
+        auto modelId = modelIds.emplace(model, static_cast<uint32_t>(models.size()));
+        if(modelId.second){
+            if(models.size() > MODEL_MASK){
+                throw std::runtime_error("too many models in render queue!");
+            }
+            models.push_back(model);
+        }
+        if(model != lastAddedModel){
+            unsortedModelBinds++;
+            lastAddedModel = model;
+        }
+
+        // also catches NaN
+        if(!(depth > 0.0f)){
+            depth = 0.0f;
+        }
+        uint32_t depthBits;
+        memcpy(&depthBits, &depth, sizeof(depthBits));
+
+        Entry entry{};
+        entry.key = static_cast<uint64_t>(pipelineId.first->second) << PIPELINE_SHIFT |
+                    static_cast<uint64_t>(modelId.first->second) << MODEL_SHIFT |
+                    depthBits;
+        entry.item = item;
+        entries.push_back(entry);
+    }
+
+    void LveRenderQueue::sort(){
+        if(entries.empty()){
+            return;
+        }
+        // least significant byte first, every pass is stable
+        scratch.resize(entries.size());
+        for(uint32_t shift = 0; shift < 64; shift += 8){
+            std::array<uint32_t, 256> offsets{};
+            for(const Entry &entry : entries){
+                offsets[(entry.key >> shift) & 0xff]++;
+            }
+            if(offsets[(entries[0].key >> shift) & 0xff] == entries.size()){
+                continue;
+            }
+            uint32_t offset = 0;
+            for(uint32_t &bucket : offsets){
+                uint32_t count = bucket;
+                bucket = offset;
+                offset += count;
+            }
+            for(const Entry &entry : entries){
+                scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+            }
+            entries.swap(scratch);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_pipeline.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace lve{
+
+    // Draws of one frame sorted by pipeline, then model, then depth front to back, so
+    // submitting them binds every pipeline and model once per run instead of once per draw.
+    // Each draw carries an item, an index the caller uses to find its per draw data.
+    class LveRenderQueue{
+        public:
+        struct BindCounts{
+            uint32_t draws{0};
+            uint32_t pipelineBinds{0};
+            uint32_t modelBinds{0};
+            // binds skipped because the pipeline or model was already bound
+            uint32_t redundantPipelineBinds{0};
+            uint32_t redundantModelBinds{0};
+
+            BindCounts &operator+=(const BindCounts &other);
+        };
+
+        LveRenderQueue() = default;
+
+        LveRenderQueue(const LveRenderQueue&) = delete;
+        LveRenderQueue &operator=(const LveRenderQueue &) = delete;
+
+        // starts a new frame, keeps the memory of the last one
+        void clear();
+        // depth is the distance in front of the camera, negative depths sort like 0
+        void add(LvePipeline *pipeline, LveModel *model, float depth, uint32_t item);
+        // radix sort of the keys, passes over bytes every key shares are skipped
+        void sort();
+
+        size_t size() const{return entries.size();}
+        uint32_t getItem(size_t index) const{return entries[index].item;}
+        // model binds submitting the draws in the order they were added would take
+        uint32_t getUnsortedModelBinds() const{return unsortedModelBinds;}
+
+        // binds and draws entries begin to end, calling draw(commandBuffer, item) before each
+        // draw for its push constants. Nothing is assumed to be bound when it starts, so every
+        // secondary command buffer can submit its own range
+        template<typename DrawFunction>
+        BindCounts submit(VkCommandBuffer commandBuffer, size_t begin, size_t end, DrawFunction &&draw) const{
+            BindCounts counts{};
+            LvePipeline *boundPipeline = nullptr;
+            LveModel *boundModel = nullptr;
+            for(size_t i = begin; i < end; i++){
+                const Entry &entry = entries[i];
+                LvePipeline *pipeline = pipelines[static_cast<uint32_t>(entry.key >> PIPELINE_SHIFT)];
+                LveModel *model = models[static_cast<uint32_t>(entry.key >> MODEL_SHIFT) & MODEL_MASK];
+                if(pipeline != boundPipeline){
+                    pipeline->bind(commandBuffer);
+                    boundPipeline = pipeline;
+                    counts.pipelineBinds++;
+                }
+                else{
+                    counts.redundantPipelineBinds++;
+                }
+                if(model != boundModel){
+                    model->bind(commandBuffer);
+                    boundModel = model;
+                    counts.modelBinds++;
+                }
+                else{
+                    counts.redundantModelBinds++;
+                }
+                draw(commandBuffer, entry.item);
+                model->draw(commandBuffer);
+                counts.draws++;
+            }
+            return counts;
+        }
+
+        private:
+            // pipeline id | model id | depth bits, positive floats order like their bits
+            static constexpr uint32_t PIPELINE_SHIFT = 56;
+            static constexpr uint32_t MODEL_SHIFT = 32;
+            static constexpr uint32_t MAX_PIPELINES = 1u << 8;
+            static constexpr uint32_t MODEL_MASK = (1u << 24) - 1;
+
+            struct Entry{
+                uint64_t key;
+                uint32_t item;
+            };
+
+            std::vector<Entry> entries;
+            std::vector<Entry> scratch;
+            // ids used in the keys, only valid for the current frame
+            std::vector<LvePipeline*> pipelines;
+            std::vector<LveModel*> models;
+            std::unordered_map<LvePipeline*, uint32_t> pipelineIds;
+            std::unordered_map<LveModel*, uint32_t> modelIds;
+            LveModel *lastAddedModel{nullptr};
+            uint32_t unsortedModelBinds{0};
+    };
+}
@@ -113,7 +113,7 @@ namespace lve{
         isFrameStarted = false;
         currentFrameIndex = (currentFrameIndex +1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
         }
-       void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer){
+       void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents){
            assert(isFrameStarted && "Can't call begin Swap chain Render  pass if frame is not in progress");
            assert(commandBuffer == getCurrentCommandBuffer() &&"Can begin Swap chain render pass from a different frame");
 
@@ -132,7 +132,10 @@ namespace lve{
             renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
             renderPassInfo.pClearValues = clearValues.data();
 
-            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+            if(contents != VK_SUBPASS_CONTENTS_INLINE){
+                return;
+            }
 
             VkViewport viewport{};
             viewport.x =0.0f;
@@ -34,9 +34,16 @@ namespace lve{
 
         VkCommandBuffer beginFrame();
         void endFrame();
-       void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only execute secondary
+        // buffers, which then have to set the viewport and scissor themselves
+       void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
          void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
         float getAspectRatio() const{return  lveSwapChain -> extentAspectRatio();}
+        VkExtent2D getSwapChainExtent() const{return lveSwapChain->getSwapChainExtent();}
+        VkFramebuffer getCurrentFrameBuffer() const{
+            assert(isFrameStarted && "Cannot get frame buffer when frame not in progress");
+            return lveSwapChain->getFrameBuffer(currentImageIndex);
+        }
         std::unique_ptr<LveSwapChain> getSwapChain(){return std::move(lveSwapChain);}
 
         private:
@@ -0,0 +1,82 @@
+#include "lve_sort_and_sweep.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace lve{
+
+    void LveSortAndSweep::update(const std::vector<float>& xs, const std::vector<float>& ys,
+        const std::vector<float>& radii, float margin){
+        assert(xs.size() == ys.size() && xs.size() == radii.size() && "Ball arrays must have the same length");
+
+        const size_t count = xs.size();
+        if(order.size() != count){
+            // balls were added or removed, start over from index order
+            order.resize(count);
+            for(size_t i = 0; i < count; i++){
+                order[i] = static_cast<uint32_t>(i);
+            }
+        }
+
+        // the margin is the same for every ball, so it does not change the order
+        lastSwapCount = 0;
+        for(size_t i = 1; i < count; i++){
+            uint32_t ball = order[i];
+            float key = xs[ball] - radii[ball];
+            size_t j = i;
+            while(j > 0 && xs[order[j - 1]] - radii[order[j - 1]] > key){
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = ball;
+            lastSwapCount += i - j;
+        }
+
+        sortedMin.resize(count);
+        sortedMax.resize(count);
+        sortedY.resize(count);
+        sortedReach.resize(count);
+        for(size_t i = 0; i < count; i++){
+            uint32_t ball = order[i];
+            float reach = radii[ball] + margin;
+            sortedMin[i] = xs[ball] - reach;
+            sortedMax[i] = xs[ball] + reach;
+            sortedY[i] = ys[ball];
+            sortedReach[i] = reach;
+        }
+
+        // every interval only has to be compared with the ones starting inside it
+        pairs.clear();
+        for(size_t i = 0; i < count; i++){
+            for(size_t j = i + 1; j < count && sortedMin[j] <= sortedMax[i]; j++){
+                if(std::fabs(sortedY[j] - sortedY[i]) <= sortedReach[i] + sortedReach[j]){
+                    pairs.push_back(order[i]);
+                    pairs.push_back(order[j]);
+                }
+            }
+        }
+
+        listStart.assign(count + 1, 0);
+        for(auto ball : pairs){
+            listStart[ball + 1]++;
+        }
+        for(size_t i = 0; i < count; i++){
+            listStart[i + 1] += listStart[i];
+        }
+        overlaps.resize(pairs.size());
+        std::vector<uint32_t> fill(listStart.begin(), listStart.end() - 1);
+        for(size_t p = 0; p < pairs.size(); p += 2){
+            overlaps[fill[pairs[p]]++] = pairs[p + 1];
+            overlaps[fill[pairs[p + 1]]++] = pairs[p];
+        }
+        for(size_t i = 0; i < count; i++){
+            std::sort(overlaps.begin() + listStart[i], overlaps.begin() + listStart[i + 1]);
+        }
+    }
+
+    void LveSortAndSweep::query(uint32_t ball, std::vector<uint32_t>& out) const{
+        out.insert(out.end(), overlaps.begin() + listStart[ball], overlaps.begin() + listStart[ball + 1]);
+    }
+
+}
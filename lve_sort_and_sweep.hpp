@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve{
+
+    // Sort and sweep broadphase for the ball physics. Balls are kept sorted by the left
+    // end of their interval on the x axis and the order is carried over between steps,
+    // so the insertion sort that restores it only has to move the few balls that passed
+    // each other. Unlike the uniform grid it does not care how uneven the radii are.
+    class LveSortAndSweep{
+        public:
+
+        // every box is the ball's radius plus margin on all sides
+        void update(const std::vector<float>& xs, const std::vector<float>& ys,
+            const std::vector<float>& radii, float margin);
+
+        // appends every other ball whose box overlaps the one of ball in ascending index order
+        void query(uint32_t ball, std::vector<uint32_t>& out) const;
+
+        size_t getPairCount() const{return pairs.size() / 2;}
+        // swaps done by the last update, close to 0 when the order barely changed
+        size_t getLastSwapCount() const{return lastSwapCount;}
+
+        private:
+            std::vector<uint32_t> order;
+            std::vector<float> sortedMin, sortedMax, sortedY, sortedReach;
+            // overlapping pairs, each one stored as both (a, b) and (b, a)
+            std::vector<uint32_t> pairs;
+            // overlaps of every ball, listStart[i] to listStart[i + 1] in overlaps
+            std::vector<uint32_t> listStart;
+            std::vector<uint32_t> overlaps;
+            size_t lastSwapCount{0};
+    };
+}
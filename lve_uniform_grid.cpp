@@ -0,0 +1,61 @@
+#include "lve_uniform_grid.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace lve{
+
+    void LveUniformGrid::build(const std::vector<float>& xs, const std::vector<float>& ys, float minCellSize){
+        assert(xs.size() == ys.size() && "Position arrays must have the same length");
+
+        const float extent = ARENA_MAX - ARENA_MIN;
+        dimension = 1;
+        if(minCellSize > 0.0f && minCellSize < extent){
+            dimension = static_cast<int>(std::floor(extent / minCellSize));
+        }
+        // keeps the cell table bounded when the radius gets very small
+        dimension = std::min(dimension, 1024);
+        cellSize = extent / dimension;
+
+        const size_t cellCount = static_cast<size_t>(dimension) * dimension;
+        cellStart.assign(cellCount + 1, 0);
+        ballCell.resize(xs.size());
+
+        for(size_t i = 0; i < xs.size(); i++){
+            uint32_t cell = cellCoord(ys[i]) * dimension + cellCoord(xs[i]);
+            ballCell[i] = cell;
+            cellStart[cell + 1]++;
+        }
+        for(size_t c = 0; c < cellCount; c++){
+            cellStart[c + 1] += cellStart[c];
+        }
+
+        // filling in index order keeps every cell sorted by ball index
+        cellBalls.resize(xs.size());
+        std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+        for(size_t i = 0; i < xs.size(); i++){
+            cellBalls[fill[ballCell[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    void LveUniformGrid::query(float x, float y, std::vector<uint32_t>& out) const{
+        const size_t first = out.size();
+        const int cx = cellCoord(x);
+        const int cy = cellCoord(y);
+
+        for(int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, dimension - 1); gy++){
+            for(int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, dimension - 1); gx++){
+                uint32_t cell = gy * dimension + gx;
+                out.insert(out.end(), cellBalls.begin() + cellStart[cell], cellBalls.begin() + cellStart[cell + 1]);
+            }
+        }
+        std::sort(out.begin() + first, out.end());
+    }
+
+    int LveUniformGrid::cellCoord(float v) const{
+        int c = static_cast<int>(std::floor((v - ARENA_MIN) / cellSize));
+        return std::clamp(c, 0, dimension - 1);
+    }
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lve{
+
+    // Uniform grid over the [-1, 1] arena, used as a broadphase for the ball physics.
+    // Balls are bucketed with a counting sort, so every cell is one contiguous range of
+    // ball indices. Positions outside the arena are clamped into the border cells.
+    class LveUniformGrid{
+        public:
+
+        // cellSize is a lower bound, the arena is split into a whole number of cells
+        void build(const std::vector<float>& xs, const std::vector<float>& ys, float cellSize);
+
+        // appends every ball from the 3x3 cells around (x, y) in ascending index order
+        void query(float x, float y, std::vector<uint32_t>& out) const;
+
+        int getDimension() const{return dimension;}
+
+        static constexpr float ARENA_MIN = -1.0f;
+        static constexpr float ARENA_MAX = 1.0f;
+
+        private:
+            int cellCoord(float v) const;
+
+            float cellSize{ARENA_MAX - ARENA_MIN};
+            int dimension{1};
+            std::vector<uint32_t> cellStart;
+            std::vector<uint32_t> cellBalls;
+            std::vector<uint32_t> ballCell;
+    };
+}
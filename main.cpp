@@ -1,11 +1,76 @@
 #include "first_app.hpp"
 
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main(){
-    lve::FirstApp app{};
+namespace{
+    const char* usage =
+        "usage: VulkanTutorial [options]\n"
+        "  --render-path P   gpu, instanced, parallel or serial (gpu)\n"
+        "  --threads N       physics and recording threads, 0 runs the ordered physics step (all cores)\n"
+        "  --stats           prints the gpu memory use at startup and frame statistics once a second\n";
+
+    // false when only the usage was asked for
+    bool parseArguments(int argc, char** argv, lve::FirstApp::Options &options){
+        for(int i = 1; i < argc; i++){
+            std::string option = argv[i];
+            if(option == "--help" || option == "-h"){
+                std::fputs(usage, stdout);
+                return false;
+            }
+            if(option == "--stats"){
+                options.printStats = true;
+            }
+            else if(option == "--threads"){
+                if(i + 1 >= argc){
+                    throw std::runtime_error("missing value for " + option);
+                }
+                options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+            else if(option == "--render-path"){
+                if(i + 1 >= argc){
+                    throw std::runtime_error("missing value for " + option);
+                }
+                std::string value = argv[++i];
+                if(value == "gpu"){
+                    options.renderPath = lve::FirstApp::RenderPath::GpuCulled;
+                }
+                else if(value == "instanced"){
+                    options.renderPath = lve::FirstApp::RenderPath::Instanced;
+                }
+                else if(value == "parallel"){
+                    options.renderPath = lve::FirstApp::RenderPath::Parallel;
+                }
+                else if(value == "serial"){
+                    options.renderPath = lve::FirstApp::RenderPath::Serial;
+                }
+                else{
+                    throw std::runtime_error("unknown render path " + value);
+                }
+            }
+            else{
+                throw std::runtime_error("unknown option " + option + "\n" + usage);
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv){
+    lve::FirstApp::Options options{};
+    try{
+        if(!parseArguments(argc, argv, options)){
+            return EXIT_SUCCESS;
+        }
+    }catch (const std::exception &e){
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    lve::FirstApp app{options};
 
     try{
         app.run();
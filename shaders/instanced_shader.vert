@@ -0,0 +1,22 @@
+#version 450
+
+
+layout(location=0) in vec3 position;
+layout(location=1) in vec3 color;
+// per instance, from LveModel::InstanceData
+layout(location=2) in mat4 instanceTransform;
+layout(location=6) in vec3 instanceColor;
+
+layout(location=0) out vec3 fragColor;
+
+// from the frame ring, the object transform comes with the instance
+layout(set = 0, binding = 0) uniform Camera{
+    mat4 projection;
+} camera;
+
+// SimpleRendererSystem::SPEC_OBJECT_COLOR, baked in when the pipeline is built
+layout(constant_id = 0) const bool OBJECT_COLOR = false;
+void main(){
+    gl_Position = camera.projection * instanceTransform * vec4(position, 1.0);
+    fragColor = OBJECT_COLOR ? instanceColor : color;
+}
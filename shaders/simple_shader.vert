@@ -7,6 +7,9 @@ layout(location=1) in vec3 color;
 
 layout(location=0) out vec3 fragColor;
 
+// SimpleRendererSystem::SPEC_OBJECT_COLOR, baked in when the pipeline is built
+layout(constant_id = 0) const bool OBJECT_COLOR = false;
+
 layout(push_constant) uniform Push{
     mat4 transform;
     vec3 color;
@@ -15,5 +18,5 @@ void main(){
     //gl_Position = vec4(push.transform*position + push.offset, 0.0, 1.0);
     //fragColor = push.color;
     gl_Position = push.transform * vec4(position, 1.0);
-    fragColor=color;
+    fragColor = OBJECT_COLOR ? push.color : color;
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "simple_render_system.hpp"
+#include "lve_swap_chain.hpp"
 
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <mutex>
 #include <stdexcept>
 #include <array>
 #include <iostream>
@@ -21,13 +24,25 @@ namespace lve{
          alignas(16) glm::vec3 color{};
     };
 
-    SimpleRendererSystem::SimpleRendererSystem(LveDevice& device, VkRenderPass renderPass) : lveDevice{device}{
+    // set 0 binding 0 of the instanced shader
+    struct CameraUbo{
+        glm::mat4 projection{1.f};
+    };
+
+    SimpleRendererSystem::SimpleRendererSystem(LveDevice& device, VkRenderPass renderPass, LveFrameRing &frameRing, LvePipelineCompiler &pipelineCompiler, bool objectColor) : lveDevice{device}, frameRing{frameRing}, pipelineCompiler{pipelineCompiler}{
 
+        SpecializationConstants constants{};
+        constants.set<VkBool32>(SPEC_OBJECT_COLOR, objectColor ? VK_TRUE : VK_FALSE);
         createPipelineLayout();
-        createPipeline(renderPass);
+        createPipeline(renderPass, constants);
+        createInstancedPipeline(renderPass, constants);
     }
 
     SimpleRendererSystem::~SimpleRendererSystem(){
+        // a pipeline still being built uses the layout
+        if(instancedPipelineFuture.valid()){
+            instancedPipelineFuture.wait();
+        }
         vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
     }
 
@@ -40,8 +55,10 @@ namespace lve{
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType =VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount =0;
-        pipelineLayoutInfo.pSetLayouts = nullptr;
+        // only the instanced shader reads the frame ring
+        VkDescriptorSetLayout setLayout = frameRing.getDescriptorSetLayout();
+        pipelineLayoutInfo.setLayoutCount =1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
         pipelineLayoutInfo.pushConstantRangeCount =1;
         pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
         if(vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
@@ -50,7 +67,7 @@ namespace lve{
         }
     }
 
-    void SimpleRendererSystem::createPipeline(VkRenderPass renderPass){
+    void SimpleRendererSystem::createPipeline(VkRenderPass renderPass, const SpecializationConstants &constants){
 
         assert(pipelineLayout != nullptr && "Cannot create pieline before pipeline layout");
         
@@ -58,48 +75,213 @@ namespace lve{
        LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
         pipelineConfig.renderPass = renderPass;
         pipelineConfig.pipelineLayout = pipelineLayout;
-        lvePipeline = std::make_unique<LvePipeline>(
-            lveDevice,
+        lvePipeline = pipelineCompiler.getVariants().get(
             "shaders/simple_shader.vert.spv",
             "shaders/simple_shader.frag.spv",
-            pipelineConfig);
+            pipelineConfig,
+            constants);
        
     }
 
+    void SimpleRendererSystem::createInstancedPipeline(VkRenderPass renderPass, const SpecializationConstants &constants){
+
+        assert(pipelineLayout != nullptr && "Cannot create pieline before pipeline layout");
+
+        VkPipelineLayout layout = pipelineLayout;
+        instancedPipelineFuture = pipelineCompiler.compile(
+            "shaders/instanced_shader.vert.spv",
+            "shaders/simple_shader.frag.spv",
+            [renderPass, layout](PipelineConfiguInfo &pipelineConfig){
+                LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+                pipelineConfig.renderPass = renderPass;
+                pipelineConfig.pipelineLayout = layout;
+                auto instanceBindings = LveModel::InstanceData::getBindingDescriptions();
+                auto instanceAttributes = LveModel::InstanceData::getAttributeDescriptions();
+                pipelineConfig.bindingDescriptions.insert(pipelineConfig.bindingDescriptions.end(), instanceBindings.begin(), instanceBindings.end());
+                pipelineConfig.attributeDescriptions.insert(pipelineConfig.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+            },
+            constants);
+    }
+
+    bool SimpleRendererSystem::isInstancedPipelineReady(){
+        if(instancedPipeline == nullptr){
+            instancedPipeline = LvePipelineCompiler::getIfReady(instancedPipelineFuture);
+        }
+        return instancedPipeline != nullptr;
+    }
+
+    void SimpleRendererSystem::bindInstancedPipeline(VkCommandBuffer commandBuffer, const LveCamera &camera){
+        instancedPipeline->bind(commandBuffer);
+        CameraUbo ubo{};
+        ubo.projection = camera.getProjectionView();
+        auto cameraData = frameRing.push(ubo);
+        frameRing.bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, cameraData.offset);
+    }
+
+    void SimpleRendererSystem::animate(LveGameObject &obj){
+        // balls are moved by the physics system, only the demo objects spin
+        if(obj.ballIndex < 0){
+            obj.transform.rotation.y = glm::mod(obj.transform.rotation.y + 0.01f, glm::two_pi<float>());
+            obj.transform.rotation.x = glm::mod(obj.transform.rotation.x + 0.005f, glm::two_pi<float>());
+            obj.transform.translation.z += 0.001f;
+        }
+    }
+
+
+    void SimpleRendererSystem::queueVisibleObjects(std::vector<LveGameObject> &gameObjects, const LveCamera &camera){
+        auto planes = camera.getFrustumPlanes();
+        glm::mat4 projectionView = camera.getProjectionView();
+        cullCounts = {};
+        renderQueue.clear();
+        for(uint32_t i = 0; i < gameObjects.size(); i++){
+            auto& obj = gameObjects[i];
+            glm::vec4 sphere = obj.getWorldBoundingSphere();
+            if(!LveCamera::isSphereVisible(planes, glm::vec3{sphere}, sphere.w)){
+                cullCounts.culled++;
+                continue;
+            }
+            cullCounts.visible++;
+            // clip w is the distance in front of the camera
+            float depth = (projectionView * glm::vec4{glm::vec3{sphere}, 1.0f}).w;
+            renderQueue.add(lvePipeline.get(), obj.model.get(), depth, i);
+        }
+        renderQueue.sort();
+    }
 
     void SimpleRendererSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects, const LveCamera& camera){
-        lvePipeline ->bind(commandBuffer);
-  
-        
-    
-         for(auto& obj: gameObjects){
-              
-                   obj.transform.rotation.y = glm::mod(obj.transform.rotation.y + 0.01f, glm::two_pi<float>());
-                obj.transform.rotation.x = glm::mod(obj.transform.rotation.x + 0.005f, glm::two_pi<float>());
-                   //std::cout <<"rotation x : "<< obj.transform.rotation.x<< "\n";
-                   // std::cout <<"{x,y,z}: {"<< obj.transform.x << ", "<< obj.transform.y << ", "<<obj.transform.z<<"} \n";    
-                   obj.transform.translation.z += 0.001f;
-               
-                    SimplePushConstantData push{};
-
-                    // my code
-
-                    push.color = obj.color;
-                   push.transform = camera.getProjection() *obj.transform.mat4();
-
-                  
-
-                    vkCmdPushConstants(commandBuffer,
-                                       pipelineLayout,
-                                       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                                       0,
-                                       sizeof(SimplePushConstantData),
-                                       &push);
-
-                    obj.model->bind(commandBuffer);
-                    obj.model->draw(commandBuffer);
-                }
-         
+        queueVisibleObjects(gameObjects, camera);
+        glm::mat4 projectionView = camera.getProjectionView();
+
+        bindCounts = renderQueue.submit(commandBuffer, 0, renderQueue.size(),
+            [&](VkCommandBuffer commandBuffer, uint32_t item){
+                auto& obj = gameObjects[item];
+                SimplePushConstantData push{};
+
+                // my code
+
+                push.color = obj.color;
+                push.transform = projectionView *obj.transform.mat4();
+
+                vkCmdPushConstants(commandBuffer,
+                                   pipelineLayout,
+                                   VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                                   0,
+                                   sizeof(SimplePushConstantData),
+                                   &push);
+            });
+    }
+
+    void SimpleRendererSystem::renderGameObjectsParallel(VkCommandBuffer commandBuffer, int frameIndex, LveParallelRecorder &recorder, const LveParallelRecorder::Target &target, std::vector<LveGameObject> &gameObjects, const LveCamera &camera){
+        queueVisibleObjects(gameObjects, camera);
+        glm::mat4 projectionView = camera.getProjectionView();
+        std::mutex countsMutex;
+        bindCounts = {};
+
+        // every secondary buffer submits its own range of the sorted queue
+        recorder.record(commandBuffer, frameIndex, target, renderQueue.size(), PARALLEL_GRAIN_SIZE,
+            [&](VkCommandBuffer chunkBuffer, size_t begin, size_t end, unsigned /*worker*/){
+                auto chunkCounts = renderQueue.submit(chunkBuffer, begin, end,
+                    [&](VkCommandBuffer chunkBuffer, uint32_t item){
+                        auto& obj = gameObjects[item];
+                        SimplePushConstantData push{};
+                        push.color = obj.color;
+                        push.transform = projectionView * obj.transform.mat4();
+                        vkCmdPushConstants(chunkBuffer,
+                                           pipelineLayout,
+                                           VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                                           0,
+                                           sizeof(SimplePushConstantData),
+                                           &push);
+                    });
+                std::lock_guard<std::mutex> lock{countsMutex};
+                bindCounts += chunkCounts;
+            });
+    }
+
+    void SimpleRendererSystem::animateGameObjects(std::vector<LveGameObject> &gameObjects){
+        for(auto& obj : gameObjects){
+            animate(obj);
+        }
+    }
+
+    void SimpleRendererSystem::renderCulledGameObjects(VkCommandBuffer commandBuffer, int frameIndex, const LveGpuCulling &culling, const LveCamera &camera){
+        const auto& groups = culling.getDrawGroups();
+        if(groups.empty() || !isInstancedPipelineReady()){
+            return;
+        }
+
+        bindInstancedPipeline(commandBuffer, camera);
+        VkBuffer instances = culling.getInstanceBuffer(frameIndex);
+        for(size_t g = 0; g < groups.size(); g++){
+            // the commands start at instance 0, the group's range is selected by the binding offset
+            VkDeviceSize offset = sizeof(LveModel::InstanceData) * groups[g].firstInstance;
+            vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instances, &offset);
+            groups[g].model->bind(commandBuffer);
+            groups[g].model->drawIndirectCount(commandBuffer,
+                                               culling.getDrawCommandBuffer(frameIndex),
+                                               LveGpuCulling::DRAW_COMMAND_STRIDE * g,
+                                               culling.getDrawCountBuffer(frameIndex),
+                                               sizeof(uint32_t) * g);
+        }
+    }
+
+    void SimpleRendererSystem::renderGameObjectsInstanced(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects, const LveCamera& camera){
+        if(!isInstancedPipelineReady()){
+            return;
+        }
+        // first pass counts the visible objects of every model, second writes each group contiguously
+        instanceGroups.clear();
+        groupOfModel.clear();
+        objectGroup.resize(gameObjects.size());
+        auto planes = camera.getFrustumPlanes();
+        cullCounts = {};
+        for(size_t i = 0; i < gameObjects.size(); i++){
+            glm::vec4 sphere = gameObjects[i].getWorldBoundingSphere();
+            if(!LveCamera::isSphereVisible(planes, glm::vec3{sphere}, sphere.w)){
+                objectGroup[i] = CULLED;
+                cullCounts.culled++;
+                continue;
+            }
+            cullCounts.visible++;
+            LveModel *model = gameObjects[i].model.get();
+            auto inserted = groupOfModel.emplace(model, static_cast<uint32_t>(instanceGroups.size()));
+            if(inserted.second){
+                instanceGroups.push_back({model, 0, 0});
+            }
+            objectGroup[i] = inserted.first->second;
+            instanceGroups[objectGroup[i]].count++;
+        }
+        uint32_t first = 0;
+        for(auto& group : instanceGroups){
+            group.first = first;
+            first += group.count;
+            group.count = 0;
+        }
+
+        if(instanceGroups.empty()){
+            return;
+        }
+        auto instanceData = frameRing.allocateVertices(sizeof(LveModel::InstanceData) * cullCounts.visible);
+        auto instances = static_cast<LveModel::InstanceData*>(instanceData.mapped);
+        for(size_t i = 0; i < gameObjects.size(); i++){
+            if(objectGroup[i] == CULLED){
+                continue;
+            }
+            auto& obj = gameObjects[i];
+            InstanceGroup& group = instanceGroups[objectGroup[i]];
+            LveModel::InstanceData& instance = instances[group.first + group.count++];
+            instance.transform = obj.transform.mat4();
+            instance.color = obj.color;
+        }
+
+        bindInstancedPipeline(commandBuffer, camera);
+        // a large frame may have got its own buffer instead of a piece of the ring
+        VkDeviceSize offset = instanceData.offset;
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceData.buffer, &offset);
+        for(auto& group : instanceGroups){
+            group.model->bind(commandBuffer);
+            group.model->draw(commandBuffer, group.count, group.first);
+        }
     }
   
 
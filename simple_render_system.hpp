@@ -6,27 +6,72 @@
 #include "lve_model.hpp"
 #include "lve_game_object.hpp"
 #include "lve_camera.hpp"
+#include "lve_gpu_culling.hpp"
+#include "lve_frame_ring.hpp"
+#include "lve_parallel_recorder.hpp"
+#include "lve_pipeline_compiler.hpp"
+#include "lve_render_queue.hpp"
 
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 namespace lve{
     class SimpleRendererSystem{
         public:
+        static constexpr size_t PARALLEL_GRAIN_SIZE = 2048;
+        // constant_id of the shaders' OBJECT_COLOR constant
+        static constexpr uint32_t SPEC_OBJECT_COLOR = 0;
 
-
-        SimpleRendererSystem(LveDevice& device, VkRenderPass renderPass);
+        // the instanced and culled paths take their camera and instance data from frameRing,
+        // which the caller has to begin every frame. Their pipeline is built by pipelineCompiler
+        // and they draw nothing until it is ready. objectColor colours objects with their
+        // LveGameObject::color instead of the vertex colours, baked into the pipelines
+        SimpleRendererSystem(LveDevice& device, VkRenderPass renderPass, LveFrameRing &frameRing, LvePipelineCompiler &pipelineCompiler, bool objectColor);
         ~SimpleRendererSystem();
 
         SimpleRendererSystem(const SimpleRendererSystem&) = delete;
         SimpleRendererSystem &operator=(const SimpleRendererSystem &) = delete;
         
 
+        // objects whose bounding sphere is outside the camera frustum are skipped by both of these,
+        // the others are drawn sorted by model and depth through the render queue. The objects
+        // have to be animated already
         void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &GameObjects, const LveCamera &camera);
+        // same draws as renderGameObjects recorded by recorder's threads, PARALLEL_GRAIN_SIZE
+        // objects per secondary buffer. The render pass has to be begun for secondary buffers
+        // and the objects already animated
+        void renderGameObjectsParallel(VkCommandBuffer commandBuffer, int frameIndex, LveParallelRecorder &recorder, const LveParallelRecorder::Target &target, std::vector<LveGameObject> &gameObjects, const LveCamera &camera);
+        // groups the objects by model and draws every group with one instanced draw, the
+        // instances are written to the frame ring. The fallback when GPU culling is unavailable
+        void renderGameObjectsInstanced(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects, const LveCamera &camera);
+        // draws what culling.cull packed for frameIndex, one indirect draw per model
+        void renderCulledGameObjects(VkCommandBuffer commandBuffer, int frameIndex, const LveGpuCulling &culling, const LveCamera &camera);
+        // spins the demo objects, the instanced and culled paths leave that to the caller
+        void animateGameObjects(std::vector<LveGameObject> &gameObjects);
+
+        struct CullCounts{
+            uint32_t visible{0};
+            uint32_t culled{0};
+        };
+        // objects drawn and skipped by the last CPU culled render call
+        const CullCounts& getCullCounts() const{return cullCounts;}
+        // binds of the last render queue submission, and the model binds it would have taken
+        // in gameObjects order
+        const LveRenderQueue::BindCounts& getBindCounts() const{return bindCounts;}
+        uint32_t getUnsortedModelBinds() const{return renderQueue.getUnsortedModelBinds();}
         private:
           
             void createPipelineLayout();
-            void createPipeline(VkRenderPass renderPass);
+            void createPipeline(VkRenderPass renderPass, const SpecializationConstants &constants);
+            void createInstancedPipeline(VkRenderPass renderPass, const SpecializationConstants &constants);
+            void animate(LveGameObject &obj);
+            // culls the objects into the render queue and sorts it
+            void queueVisibleObjects(std::vector<LveGameObject> &gameObjects, const LveCamera &camera);
+            // takes the instanced pipeline over from the compiler once it is built
+            bool isInstancedPipelineReady();
+            // binds the instanced pipeline and the camera data at set 0
+            void bindInstancedPipeline(VkCommandBuffer commandBuffer, const LveCamera &camera);
 
             
             //my code:
@@ -34,9 +79,28 @@ namespace lve{
 
         
             LveDevice &lveDevice;
+            LveFrameRing &frameRing;
+            LvePipelineCompiler &pipelineCompiler;
            
-            std::unique_ptr<LvePipeline> lvePipeline;
+            std::shared_ptr<LvePipeline> lvePipeline;
+            std::shared_ptr<LvePipeline> instancedPipeline;
+            LvePipelineCompiler::PipelineFuture instancedPipelineFuture;
             VkPipelineLayout pipelineLayout;
+
+            // reused every frame so grouping does not allocate once it has warmed up
+            struct InstanceGroup{
+                LveModel *model;
+                uint32_t first;
+                uint32_t count;
+            };
+            std::vector<InstanceGroup> instanceGroups;
+            std::unordered_map<LveModel*, uint32_t> groupOfModel;
+            // objectGroup of objects outside the frustum
+            static constexpr uint32_t CULLED = UINT32_MAX;
+            std::vector<uint32_t> objectGroup;
+            CullCounts cullCounts{};
+            LveRenderQueue renderQueue;
+            LveRenderQueue::BindCounts bindCounts{};
            
     };
 }
@@ -0,0 +1,558 @@
+// Headless tests of the parts that do not need a window or GPU: the physics broadphases and
+// narrowphase kernels, the AABB tree, the device memory allocator, the render queue and the
+// pipeline cache file. The few Vulkan calls the allocator and the pipeline cache make are
+// answered by fakes at the bottom of this file, so it links without the Vulkan loader.
+// Build and run with `make check`.
+
+#include "lve_aabb_tree.hpp"
+#include "lve_allocator.hpp"
+#include "lve_ball_physics.hpp"
+#include "lve_ball_store.hpp"
+#include "lve_narrowphase.hpp"
+#include "lve_pipeline_cache.hpp"
+#include "lve_render_queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lve;
+
+namespace{
+
+    int failures = 0;
+
+    void check(bool condition, const char* what){
+        if(!condition){
+            std::printf("  FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // ---- fake Vulkan state, see the definitions at the bottom ----
+
+    struct FakeMemory{
+        std::unique_ptr<char[]> data;
+    };
+    std::map<VkDeviceMemory, FakeMemory> liveMemory;
+
+    struct FakePipelineCache{
+        std::vector<char> data;
+    };
+    // what the driver puts into a cache that started empty
+    const std::vector<char> DRIVER_CACHE_DATA{'d', 'r', 'i', 'v', 'e', 'r', ' ', 'd', 'a', 't', 'a'};
+    // initial data handed to the last vkCreatePipelineCache
+    std::vector<char> lastInitialData;
+    int livePipelineCaches = 0;
+
+    // ---- physics ----
+
+    // balls on a jittered lattice, every tenth one heavy so impacts can speed the light ones
+    // up past the broadphase's first guess of how far balls travel
+    void spawnBalls(int count, float maxRadius, float maxSpeed, uint32_t seed, LveBallStore& balls){
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const int perRow = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const float cell = 2.0f / perRow;
+        for(int i = 0; i < count; i++){
+            float radius = maxRadius * (0.3f + 0.7f * unit(rng));
+            float slack = cell * 0.5f - radius;
+            float x = -1.0f + cell * (i % perRow + 0.5f) + slack * (2.0f * unit(rng) - 1.0f);
+            float y = -1.0f + cell * (i / perRow + 0.5f) + slack * (2.0f * unit(rng) - 1.0f);
+            float mass = i % 10 == 0 ? 1000.0f * radius : radius;
+            balls.add(x, y, maxSpeed * (2.0f * unit(rng) - 1.0f), maxSpeed * (2.0f * unit(rng) - 1.0f), radius, mass);
+        }
+    }
+
+    bool sameState(const LveBallStore& a, const LveBallStore& b){
+        return a.x == b.x && a.y == b.y && a.vx == b.vx && a.vy == b.vy;
+    }
+
+    void testBroadphasesAgree(){
+        std::printf("broadphases agree with brute force\n");
+        const PhysicsSystem::Broadphase broadphases[] = {PhysicsSystem::Broadphase::UniformGrid,
+            PhysicsSystem::Broadphase::SortAndSweep, PhysicsSystem::Broadphase::AabbTree};
+
+        for(unsigned threads : {0u, 1u, 4u}){
+            LveBallStore reference;
+            spawnBalls(600, 0.02f, 1.0f, 7, reference);
+            PhysicsSystem referencePhysics{reference, PhysicsSystem::Broadphase::BruteForce};
+            referencePhysics.setThreadCount(threads);
+            for(int step = 0; step < 60; step++){
+                referencePhysics.update(1.0f / 60.0f);
+            }
+            for(auto broadphase : broadphases){
+                LveBallStore balls;
+                spawnBalls(600, 0.02f, 1.0f, 7, balls);
+                PhysicsSystem physics{balls, broadphase};
+                physics.setThreadCount(threads);
+                for(int step = 0; step < 60; step++){
+                    physics.update(1.0f / 60.0f);
+                }
+                check(sameState(balls, reference), threads == 0 ? "ordered step matches brute force" : "parallel step matches brute force");
+            }
+        }
+
+        // a few balls packed within a couple of radii of each other, heavy ones next to light
+        // ones, so chained impacts throw light balls further than twice the fastest speed
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        int mismatches = 0;
+        for(int trial = 0; trial < 20000; trial++){
+            LveBallStore reference, balls;
+            std::vector<float> xs, ys;
+            const int count = 8 + static_cast<int>(rng() % 12);
+            for(int i = 0; i < count; i++){
+                float x = 0.0f, y = 0.0f;
+                bool isFree = false;
+                for(int tries = 0; tries < 100 && !isFree; tries++){
+                    x = unit(rng) * (i < 4 ? 0.012f : 0.12f);
+                    y = unit(rng) * 0.006f;
+                    isFree = true;
+                    for(size_t k = 0; k < xs.size(); k++){
+                        float dx = x - xs[k], dy = y - ys[k];
+                        isFree = isFree && dx * dx + dy * dy >= 0.008f * 0.008f * 1.0001f;
+                    }
+                }
+                if(!isFree){
+                    continue;
+                }
+                xs.push_back(x);
+                ys.push_back(y);
+                bool heavy = rng() % 2 == 0;
+                float speed = heavy ? 1.0f : 0.05f;
+                float vx = unit(rng) * speed, vy = unit(rng) * 0.2f * speed;
+                reference.add(x, y, vx, vy, 0.004f, heavy ? 1000.0f : 1.0f);
+                balls.add(x, y, vx, vy, 0.004f, heavy ? 1000.0f : 1.0f);
+            }
+            PhysicsSystem referencePhysics{reference, PhysicsSystem::Broadphase::BruteForce};
+            PhysicsSystem physics{balls, PhysicsSystem::Broadphase::SortAndSweep};
+            referencePhysics.update(1.0f / 60.0f);
+            physics.update(1.0f / 60.0f);
+            mismatches += sameState(balls, reference) ? 0 : 1;
+        }
+        check(mismatches == 0, "sort and sweep finds impacts after chained impacts");
+    }
+
+    void testNarrowphaseKernelsAgree(){
+        std::printf("narrowphase kernels agree with the scalar one\n");
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f), time(0.0f, 0.01f);
+        LveNarrowphase scalar{LveNarrowphase::Kernel::Scalar};
+        for(auto kernel : {LveNarrowphase::Kernel::SSE, LveNarrowphase::Kernel::AVX2}){
+            if(!LveNarrowphase::isSupported(kernel)){
+                std::printf("  %s not supported, skipped\n", LveNarrowphase::kernelName(kernel));
+                continue;
+            }
+            LveNarrowphase simd{kernel};
+            int mismatches = 0, hits = 0;
+            for(int trial = 0; trial < 20000; trial++){
+                // counts that are not a multiple of the lane width also test the scalar tail
+                const size_t count = 1 + rng() % 40;
+                std::vector<float> x(count), y(count), vx(count), vy(count), radius(count), start(count);
+                for(size_t k = 0; k < count; k++){
+                    x[k] = unit(rng) * 0.2f;
+                    y[k] = unit(rng) * 0.2f;
+                    vx[k] = unit(rng) * 5.0f;
+                    vy[k] = unit(rng) * 5.0f;
+                    radius[k] = 0.01f + 0.02f * std::fabs(unit(rng));
+                    start[k] = rng() % 3 == 0 ? 0.0f : time(rng);
+                }
+                LveNarrowphase::SweptCircle circle{unit(rng) * 0.2f, unit(rng) * 0.2f, unit(rng) * 5.0f,
+                    unit(rng) * 5.0f, 0.02f, rng() % 2 == 0 ? 0.0f : time(rng)};
+                LveNarrowphase::SweptBatch batch{x.data(), y.data(), vx.data(), vy.data(), radius.data(), start.data()};
+                float scalarTime = 0.0f, simdTime = 0.0f;
+                size_t scalarHit = scalar.findEarliestImpact(circle, batch, count, 0.01f, scalarTime);
+                size_t simdHit = simd.findEarliestImpact(circle, batch, count, 0.01f, simdTime);
+                if(scalarHit != simdHit || (scalarHit < count && scalarTime != simdTime)){
+                    mismatches++;
+                }
+                hits += scalarHit < count ? 1 : 0;
+            }
+            check(mismatches == 0, LveNarrowphase::kernelName(kernel));
+            check(hits > 1000, "enough trials hit something");
+        }
+    }
+
+    void testAabbTree(){
+        std::printf("aabb tree insert, remove and query\n");
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f), size(0.001f, 0.05f);
+        auto randomBox = [&](){
+            float x = unit(rng), y = unit(rng);
+            return LveAabb{x, y, x + size(rng), y + size(rng)};
+        };
+
+        LveAabbTree tree;
+        std::vector<LveAabb> boxes;
+        std::vector<int32_t> proxies;
+        std::vector<bool> alive;
+        for(uint32_t i = 0; i < 2000; i++){
+            boxes.push_back(randomBox());
+            proxies.push_back(tree.createProxy(boxes.back(), i));
+            alive.push_back(true);
+        }
+        for(uint32_t i = 0; i < 2000; i += 3){
+            tree.destroyProxy(proxies[i]);
+            alive[i] = false;
+        }
+        for(uint32_t i = 1; i < 2000; i += 7){
+            if(alive[i]){
+                boxes[i] = randomBox();
+                tree.moveProxy(proxies[i], boxes[i], 0.0f, 0.0f);
+            }
+        }
+        const size_t aliveCount = static_cast<size_t>(std::count(alive.begin(), alive.end(), true));
+        check(tree.getProxyCount() == aliveCount, "proxy count after removals");
+        // a balanced tree of n leaves is about log2(n) high
+        check(tree.getHeight() <= 2 * static_cast<int>(std::log2(static_cast<float>(aliveCount)) + 1), "tree stays balanced");
+
+        bool allFound = true, onlyAlive = true, onlyOverlapping = true;
+        std::vector<uint32_t> found;
+        for(int query = 0; query < 500; query++){
+            LveAabb box = randomBox();
+            box.maxX += 0.1f;
+            box.maxY += 0.1f;
+            found.clear();
+            tree.query(box, found);
+            std::sort(found.begin(), found.end());
+            for(uint32_t i = 0; i < boxes.size(); i++){
+                bool reported = std::binary_search(found.begin(), found.end(), i);
+                if(alive[i] && box.overlaps(boxes[i]) && !reported){
+                    allFound = false;
+                }
+                if(!alive[i] && reported){
+                    onlyAlive = false;
+                }
+            }
+            for(auto i : found){
+                if(alive[i] && !box.overlaps(tree.getFatAabb(proxies[i]))){
+                    onlyOverlapping = false;
+                }
+            }
+        }
+        check(allFound, "query reports every overlapping box");
+        check(onlyAlive, "query never reports removed boxes");
+        check(onlyOverlapping, "query only reports fat boxes that overlap");
+
+        tree.clear();
+        found.clear();
+        tree.query({-2.0f, -2.0f, 2.0f, 2.0f}, found);
+        check(found.empty() && tree.getProxyCount() == 0, "clear empties the tree");
+    }
+
+    // ---- allocator ----
+
+    VkMemoryRequirements requirements(VkDeviceSize size, VkDeviceSize alignment){
+        VkMemoryRequirements memoryRequirements{};
+        memoryRequirements.size = size;
+        memoryRequirements.alignment = alignment;
+        memoryRequirements.memoryTypeBits = ~0u;
+        return memoryRequirements;
+    }
+
+    void testAllocator(){
+        std::printf("allocator ranges\n");
+        {
+            // memory type 0 is device local on a 1 GiB heap, so blocks are DEFAULT_BLOCK_SIZE
+            LveAllocator allocator{VK_NULL_HANDLE, VK_NULL_HANDLE};
+            const VkDeviceSize blockSize = LveAllocator::DEFAULT_BLOCK_SIZE;
+
+            LveAllocation a = allocator.allocate(requirements(1024, 256), 0, true);
+            LveAllocation b = allocator.allocate(requirements(1024, 256), 0, true);
+            LveAllocation c = allocator.allocate(requirements(1024, 256), 0, true);
+            check(a.offset == 0 && b.offset == 1024 && c.offset == 2048, "ranges are handed out front to back");
+            check(a.memory == b.memory && b.memory == c.memory && a.block == 0, "small ranges share one block");
+            check(liveMemory.size() == 1, "one device allocation for the block");
+
+            allocator.free(b);
+            check(b.memory == VK_NULL_HANDLE, "free resets the allocation");
+            check(allocator.getStats().freeRangeCount == 2, "freed range stays apart from the tail");
+            allocator.free(a);
+            LveAllocator::Stats stats = allocator.getStats();
+            check(stats.freeRangeCount == 2, "freed neighbours merge");
+            check(stats.largestFreeRange == blockSize - 3072, "tail range is untouched");
+
+            // best fit takes the merged 2048 byte range in front instead of the tail
+            LveAllocation merged = allocator.allocate(requirements(2048, 256), 0, true);
+            check(merged.offset == 0, "merged range is reused");
+            allocator.free(merged);
+            allocator.free(c);
+            stats = allocator.getStats();
+            check(stats.freeRangeCount == 1 && stats.freeBytes == blockSize, "everything merges back into one range");
+            check(stats.fragmentation() == 0.0f && stats.usedBytes == 0, "no fragmentation once empty");
+
+            // the padding in front of an aligned range stays free and merges back too
+            LveAllocation small = allocator.allocate(requirements(100, 1), 0, true);
+            LveAllocation aligned = allocator.allocate(requirements(100, 256), 0, true);
+            check(aligned.offset == 256, "offset is aligned");
+            check(allocator.getStats().freeRangeCount == 2, "padding is a free range");
+            allocator.free(small);
+            allocator.free(aligned);
+            check(allocator.getStats().freeRangeCount == 1, "padding merges back");
+
+            // linear and optimal resources never share a block
+            LveAllocation buffer = allocator.allocate(requirements(1024, 256), 0, true);
+            LveAllocation image = allocator.allocate(requirements(1024, 256), 0, false);
+            check(buffer.memory != image.memory, "images get their own block");
+            allocator.free(buffer);
+            allocator.free(image);
+
+            LveAllocation large = allocator.allocate(requirements(blockSize / 2 + 1, 256), 0, true);
+            check(large.block == -1 && allocator.getStats().dedicatedAllocationCount == 1, "large requests get dedicated memory");
+            allocator.free(large);
+            check(allocator.getStats().dedicatedAllocationCount == 0, "dedicated memory is freed right away");
+
+            // memory type 1 is host visible, ranges point into the mapped block
+            LveAllocation first = allocator.allocate(requirements(64, 64), 1, true);
+            LveAllocation second = allocator.allocate(requirements(64, 64), 1, true);
+            check(first.mapped != nullptr && static_cast<char*>(second.mapped) - static_cast<char*>(first.mapped) == 64,
+                "host visible ranges are mapped at their offset");
+            allocator.free(first);
+            allocator.free(second);
+        }
+        check(liveMemory.empty(), "destroying the allocator frees its blocks");
+    }
+
+    // ---- render queue ----
+
+    struct Bind{
+        bool pipeline;
+        const void* object;
+    };
+    std::vector<Bind> binds;
+    std::vector<uint32_t> drawnItems;
+
+    void testRenderQueue(){
+        std::printf("render queue order and bind counts\n");
+        // never dereferenced, the fake bind and draw below only record the addresses
+        alignas(LvePipeline) static unsigned char pipelineStorage[2][sizeof(LvePipeline)];
+        alignas(LveModel) static unsigned char modelStorage[3][sizeof(LveModel)];
+        LvePipeline* pipelines[2] = {reinterpret_cast<LvePipeline*>(pipelineStorage[0]), reinterpret_cast<LvePipeline*>(pipelineStorage[1])};
+        LveModel* models[3] = {reinterpret_cast<LveModel*>(modelStorage[0]), reinterpret_cast<LveModel*>(modelStorage[1]),
+            reinterpret_cast<LveModel*>(modelStorage[2])};
+
+        struct Draw{
+            int pipeline, model;
+            float depth;
+        };
+        // interleaved so every draw would rebind in the order they are added
+        const std::vector<Draw> draws = {
+            {1, 2, 0.5f}, {0, 1, 3.0f}, {1, 0, 1.0f}, {0, 1, 1.0f}, {0, 0, 2.0f},
+            {1, 2, 0.25f}, {0, 1, -1.0f}, {1, 0, 0.5f}, {0, 0, 4.0f}, {1, 2, 2.0f}};
+
+        LveRenderQueue queue;
+        for(int frame = 0; frame < 2; frame++){
+            queue.clear();
+            for(uint32_t i = 0; i < draws.size(); i++){
+                queue.add(pipelines[draws[i].pipeline], models[draws[i].model], draws[i].depth, i);
+            }
+            check(queue.getUnsortedModelBinds() == 9, "unsorted binds count every model change");
+            queue.sort();
+            check(queue.size() == draws.size(), "every draw is kept");
+
+            // pipelines and models get their ids in the order they are first added, so
+            // pipeline 1 with models 2 then 0 sorts first, then pipeline 0 with models 1 then 0
+            bool ordered = true;
+            const int expectedGroups[][2] = {{1, 2}, {1, 2}, {1, 2}, {1, 0}, {1, 0}, {0, 1}, {0, 1}, {0, 1}, {0, 0}, {0, 0}};
+            for(size_t i = 0; i < queue.size(); i++){
+                const Draw& draw = draws[queue.getItem(i)];
+                if(draw.pipeline != expectedGroups[i][0] || draw.model != expectedGroups[i][1]){
+                    ordered = false;
+                }
+                // front to back within a group, negative depths count as 0
+                if(i > 0 && expectedGroups[i][0] == expectedGroups[i - 1][0] && expectedGroups[i][1] == expectedGroups[i - 1][1] &&
+                   std::max(draws[queue.getItem(i - 1)].depth, 0.0f) > std::max(draw.depth, 0.0f)){
+                    ordered = false;
+                }
+            }
+            check(ordered, "sorted by pipeline, model, then depth");
+
+            binds.clear();
+            drawnItems.clear();
+            LveRenderQueue::BindCounts counts = queue.submit(VK_NULL_HANDLE, 0, queue.size(),
+                [](VkCommandBuffer, uint32_t item){drawnItems.push_back(item);});
+            check(counts.draws == 10 && drawnItems.size() == 10, "every draw is submitted");
+            check(counts.pipelineBinds == 2 && counts.redundantPipelineBinds == 8, "pipeline bound once per run");
+            check(counts.modelBinds == 4 && counts.redundantModelBinds == 6, "model bound once per run");
+            check(binds.size() == 6 && binds[0].pipeline && binds[0].object == pipelines[1], "binds start with the first pipeline");
+
+            // a range starting in the middle of a run binds what it needs again
+            LveRenderQueue::BindCounts tail = queue.submit(VK_NULL_HANDLE, 4, queue.size(), [](VkCommandBuffer, uint32_t){});
+            check(tail.pipelineBinds == 2 && tail.modelBinds == 3, "ranges bind from scratch");
+        }
+    }
+
+    // ---- pipeline cache ----
+
+    VkPhysicalDeviceProperties deviceProperties(uint32_t deviceID, uint8_t uuidByte){
+        VkPhysicalDeviceProperties properties{};
+        properties.vendorID = 0x10de;
+        properties.deviceID = deviceID;
+        properties.driverVersion = 42;
+        std::memset(properties.pipelineCacheUUID, uuidByte, VK_UUID_SIZE);
+        return properties;
+    }
+
+    std::vector<char> readFile(const std::string& path){
+        std::ifstream file{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    void writeFile(const std::string& path, const std::vector<char>& data){
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file.write(data.data(), data.size());
+    }
+
+    bool loads(const std::string& path, const VkPhysicalDeviceProperties& properties){
+        LvePipelineCache cache{VK_NULL_HANDLE, properties, path};
+        return cache.wasLoaded();
+    }
+
+    void testPipelineCache(){
+        std::printf("pipeline cache file validation\n");
+        const std::string path = (std::filesystem::temp_directory_path() / "lve_headless_tests_pipeline_cache.bin").string();
+        std::remove(path.c_str());
+        const VkPhysicalDeviceProperties properties = deviceProperties(1, 7);
+
+        check(!loads(path, properties), "missing file starts empty");
+        const std::vector<char> saved = readFile(path);
+        check(saved.size() > DRIVER_CACHE_DATA.size(), "destructor saves the cache");
+        check(loads(path, properties) && lastInitialData == DRIVER_CACHE_DATA, "saved data is loaded again");
+        const size_t headerSize = saved.size() - DRIVER_CACHE_DATA.size();
+
+        writeFile(path, saved);
+        check(!loads(path, deviceProperties(2, 7)), "another device starts empty");
+        writeFile(path, saved);
+        check(!loads(path, deviceProperties(1, 8)), "another pipelineCacheUUID starts empty");
+        VkPhysicalDeviceProperties newDriver = properties;
+        newDriver.driverVersion++;
+        writeFile(path, saved);
+        check(!loads(path, newDriver), "another driver version starts empty");
+        check(lastInitialData.empty(), "foreign data never reaches the driver");
+
+        std::vector<char> damaged = saved;
+        damaged.resize(saved.size() - 3);
+        writeFile(path, damaged);
+        check(!loads(path, properties), "truncated data starts empty");
+
+        damaged = saved;
+        damaged.back() ^= 0x20;
+        writeFile(path, damaged);
+        check(!loads(path, properties), "data with a wrong checksum starts empty");
+
+        // dataSize and checksum are the last members of the header
+        damaged = saved;
+        const uint64_t hugeSize = uint64_t{1} << 60;
+        std::memcpy(damaged.data() + headerSize - 2 * sizeof(uint64_t), &hugeSize, sizeof(hugeSize));
+        writeFile(path, damaged);
+        check(!loads(path, properties), "a huge dataSize starts empty without allocating it");
+
+        damaged.assign(saved.begin(), saved.begin() + headerSize / 2);
+        writeFile(path, damaged);
+        check(!loads(path, properties), "a cut off header starts empty");
+
+        damaged = saved;
+        damaged[0] ^= 0x01;
+        writeFile(path, damaged);
+        check(!loads(path, properties), "a wrong magic starts empty");
+
+        writeFile(path, saved);
+        check(loads(path, properties), "the original file still loads");
+        check(livePipelineCaches == 0, "every cache is destroyed");
+        std::remove(path.c_str());
+    }
+}
+
+int main(){
+    testBroadphasesAgree();
+    testNarrowphaseKernelsAgree();
+    testAabbTree();
+    testAllocator();
+    testRenderQueue();
+    testPipelineCache();
+
+    if(failures > 0){
+        std::printf("%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
+
+// ---- fakes of what the tested classes call, nothing here talks to a driver ----
+
+namespace lve{
+    void LvePipeline::bind(VkCommandBuffer){
+        binds.push_back({true, this});
+    }
+    void LveModel::bind(VkCommandBuffer){
+        binds.push_back({false, this});
+    }
+    void LveModel::draw(VkCommandBuffer){}
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* properties){
+    *properties = {};
+    properties->memoryHeapCount = 2;
+    properties->memoryHeaps[0].size = VkDeviceSize{1} << 30;
+    properties->memoryHeaps[1].size = VkDeviceSize{256} << 20;
+    properties->memoryTypeCount = 2;
+    properties->memoryTypes[0] = {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0};
+    properties->memoryTypes[1] = {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1};
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* allocateInfo,
+    const VkAllocationCallbacks*, VkDeviceMemory* memory){
+    // only the host visible type is ever read through, the others just need a unique handle
+    FakeMemory fake;
+    fake.data.reset(new char[allocateInfo->memoryTypeIndex == 1 ? allocateInfo->allocationSize : 1]);
+    *memory = reinterpret_cast<VkDeviceMemory>(fake.data.get());
+    liveMemory.emplace(*memory, std::move(fake));
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*){
+    liveMemory.erase(memory);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize,
+    VkMemoryMapFlags, void** data){
+    *data = liveMemory.at(memory).data.get() + offset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineCache(VkDevice, const VkPipelineCacheCreateInfo* createInfo,
+    const VkAllocationCallbacks*, VkPipelineCache* pipelineCache){
+    auto fake = new FakePipelineCache{};
+    const char* initial = static_cast<const char*>(createInfo->pInitialData);
+    lastInitialData.assign(initial, initial + createInfo->initialDataSize);
+    fake->data = lastInitialData.empty() ? DRIVER_CACHE_DATA : lastInitialData;
+    *pipelineCache = reinterpret_cast<VkPipelineCache>(fake);
+    livePipelineCaches++;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineCache(VkDevice, VkPipelineCache pipelineCache, const VkAllocationCallbacks*){
+    delete reinterpret_cast<FakePipelineCache*>(pipelineCache);
+    livePipelineCaches--;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPipelineCacheData(VkDevice, VkPipelineCache pipelineCache, size_t* dataSize, void* data){
+    const auto& cacheData = reinterpret_cast<FakePipelineCache*>(pipelineCache)->data;
+    if(data != nullptr){
+        std::memcpy(data, cacheData.data(), std::min(*dataSize, cacheData.size()));
+    }
+    *dataSize = cacheData.size();
+    return VK_SUCCESS;
+}